@@ -1,21 +1,42 @@
 #include "radio.h"
 #include "ble_control.h"
+#include "power.h"
+#include "idle_sleep.h"
+#include "boot_timeline.h"
+#include "soak.h"
+#include "config.h"
+#include "debug_config.h"
 
 bool radio_started = false;
 
 void setup() {
   Serial.begin(115200);
-  delay(2000); 
+  boot_timeline_mark(BOOT_MARK_SETUP);
+  config_setup();
+  radio_apply_config();
+  bool resumed = idle_sleep_setup();
+  if (!resumed) {
+    delay(2000); // Give the serial monitor time to attach on a cold boot only
+  }
   Serial.println("\n=== ESP32 INTERNET RADIO WITH BLUETOOTH XBOX CONTROLLER CONTROL ===");
+  config_print_summary();
   Serial.println("Waiting for Xbox Controller to connect before starting radio...");
 
-  // Initialize Bluetooth
-  ble_control_setup();
+  #if PIPELINE_BENCHMARK
+    // The benchmark runs without BLE or a controller so they do not share the CPU
+    radio_setup();
+    radio_started = true;
+  #else
+    // Initialize Bluetooth
+    ble_control_setup();
+  #endif
 }
 
 void loop() {
-  // Always handle BLE
-  ble_control_loop();
+  // Always handle BLE (not started in benchmark mode)
+  #if !PIPELINE_BENCHMARK
+    ble_control_loop();
+  #endif
 
   // If BLE is connected and radio hasn't started yet, start the radio.
   if (ble_is_connected() && !radio_started) {
@@ -23,6 +44,7 @@ void loop() {
     Serial.println("*** Xbox Controller connected! Starting Radio... ***");
     Serial.println("========================================\n");
     radio_setup();
+    power_setup();
     radio_started = true;
     Serial.println("\n=== Setup Complete. Radio is running. ===");
   }
@@ -30,7 +52,14 @@ void loop() {
   // Only loop the radio if it has been started
   if (radio_started) {
     radio_loop();
+    #if !PIPELINE_BENCHMARK // Keep the clock fixed so benchmark runs are comparable
+      power_loop();
+    #endif
+    soak_loop();
   }
 
+  // Sleep when nobody is using the radio
+  idle_sleep_loop(radio_started && radio_is_playing());
+
   delay(10);
 }
@@ -1,5 +1,11 @@
 #include "ble_control.h"
 #include "radio.h"
+#include "boot_timeline.h"
+#include "config.h"
+#include "idle_sleep.h"
+#include "debug_config.h"
+#include "ble_link.h"
+#include "rumble_queue.h"
 
 #include <BLEDevice.h>
 #include <BLEUtils.h>
@@ -7,6 +13,7 @@
 #include <BLEScan.h>
 #include <BLEAdvertisedDevice.h>
 #include <BLESecurity.h>
+#include <esp_timer.h>
 
 // Manually define structs and enums from esp_gap_ble_api.h and esp_bt_defs.h to fix compilation issue
 typedef uint8_t esp_bd_addr_t[6];
@@ -64,25 +71,164 @@ typedef struct
 } esp_ble_auth_cmpl_t;
 
 // --- Xbox Wireless Controller Configuration ---
-static BLEAddress targetDeviceAddress("44:16:22:E3:CB:B3");
-// Xbox BLE Service UUID: 0x400000 (32-bit UUID, formatted as string for ESP32 BLE library)
-static BLEUUID serviceUUID("00400000-0000-1000-8000-00805f9b34fb"); // Xbox BLE Service (0x400000 in 128-bit format)
-static BLEUUID charUUID(uint16_t(0x2A4D));    // Standard HID Report
+// Bonded controller addresses and UUIDs come from the configuration image
+// (config.h) in binary form; the UUIDs are built in ble_control_setup().
+static BLEUUID serviceUUID;   // Xbox BLE Service (0x400000 in 128-bit format)
+static BLEUUID charUUID;      // Standard HID Report (0x2A4D)
+
+// A public and a random address with the same bytes are different devices
+static bool is_bonded_address(BLEAddress address, uint8_t addressType) {
+  const RadioConfig* cfg = config_get();
+  for (int i = 0; i < cfg->bondCount; i++) {
+    if (memcmp(*address.getNative(), cfg->bonds[i].address, 6) == 0 &&
+        cfg->bonds[i].addressType == addressType) return true;
+  }
+  return false;
+}
 
 // --- Xbox Controller D-pad Definitions ---
 #define DPAD_UP 0x01
 #define DPAD_DOWN 0x02
 
 // --- BLE State Machine ---
+// Connection state lives in ble_link.cpp; this file drives it with the stack.
 static BLEClient* pClient;
 static BLEScan* pBLEScan;
-static bool deviceConnected = false;
-static bool doConnect = false;
+static BleLink link;
 static BLEAdvertisedDevice* myDevice = nullptr;
 
+// --- Fast resume: controller cached across deep sleep ---
+static BLEAddress* fastConnectAddress = nullptr; // Direct connect target, skips the scan
+static uint8_t fastConnectAddressType = BLE_ADDR_TYPE_PUBLIC;
+static uint8_t lastAddress[6];
+static uint8_t lastAddressType = BLE_ADDR_TYPE_PUBLIC;
+static bool haveLastAddress = false;
+
+// --- Rumble Feedback ---
+// Short pulses are queued from notifyCallback() and written from the main loop
+// with write-without-response. Queueing, dropping and merging live in
+// rumble_queue.cpp; latency is measured from the notification's arrival.
+#define RUMBLE_STRENGTH_TICK  25   // Motor strength 0-100 for a command
+#define RUMBLE_STRENGTH_LIMIT 60   // Stronger buzz when a volume limit is hit
+#define RUMBLE_DURATION_TICK  3    // Units of 10 ms
+#define RUMBLE_DURATION_LIMIT 12
+#define RUMBLE_STATS_EVERY    20   // Print latency stats every N writes
+
+static RumbleQueue rumbleQueue;
+// HID output report. Cleared from the BLE task on disconnect: read it once
+// into a local before use.
+static BLERemoteCharacteristic* volatile pRumbleChar = nullptr;
+
+// Never blocks: safe to call from the BLE callback task
+static void rumble_pulse(uint8_t strength, uint8_t duration, int64_t pressedUs) {
+  if (pRumbleChar == nullptr) return;
+  rumble_queue_push(rumbleQueue, strength, duration, pressedUs);
+}
+
+static void print_rumble_stats() {
+  const RumbleStats& s = rumbleQueue.stats;
+  Serial.print("*** Rumble stats: queued=");
+  Serial.print(s.queued);
+  Serial.print(" sent=");
+  Serial.print(s.sent);
+  Serial.print(" coalesced=");
+  Serial.print(s.coalesced);
+  Serial.print(" dropped=");
+  Serial.print(s.dropped);
+  if (s.sent > 0) {
+    Serial.print(" latency us min/avg/max=");
+    Serial.print((long)s.latencyMinUs);
+    Serial.print("/");
+    Serial.print((long)(s.latencyTotalUs / s.sent));
+    Serial.print("/");
+    Serial.print((long)s.latencyMaxUs);
+  }
+  Serial.println();
+}
+
+// The output report behind the rumble queue
+class BleRumbleDriver : public RumbleDriver {
+ public:
+  BLERemoteCharacteristic* rumbleChar = nullptr;  // Sampled once per service
+  int64_t nowUs() override { return esp_timer_get_time(); }
+  bool canWrite() override { return rumbleChar != nullptr && link.connected; }
+  void write(const RumblePulse& pulse) override {
+    // Xbox BLE rumble output report: enable mask, LT, RT, left, right,
+    // duration, start delay, loop count. Only the main motors are used.
+    uint8_t report[8] = {0x03, 0, 0, pulse.strength, pulse.strength, pulse.duration, 0, 0};
+    rumbleChar->writeValue(report, sizeof(report), false);
+  }
+};
+static BleRumbleDriver rumbleDriver;
+
+// Drain the queue from the main loop, one write per pulse window
+static void rumble_service() {
+  rumbleDriver.rumbleChar = pRumbleChar;
+  if (rumble_queue_service(rumbleQueue, rumbleDriver) &&
+      rumbleQueue.stats.sent % RUMBLE_STATS_EVERY == 0) {
+    print_rumble_stats();
+  }
+}
+
+// Find the writable HID report (the output report carrying rumble). Several
+// characteristics share UUID 0x2A4D, so look them up by handle.
+static void find_rumble_characteristic(BLERemoteService* pService) {
+  BLERemoteCharacteristic* found = nullptr;
+  std::map<uint16_t, BLERemoteCharacteristic*>* byHandle = pService->getCharacteristicsByHandle();
+  for (auto const& pair : *byHandle) {
+    BLERemoteCharacteristic* pChar = pair.second;
+    if (pChar->getUUID().equals(charUUID) && pChar->canWriteNoResponse()) {
+      found = pChar;
+      break;
+    }
+  }
+  pRumbleChar = found;
+  if (found != nullptr) {
+    Serial.println(">>> Found rumble output report, feedback enabled");
+  } else {
+    Serial.println(">>> No writable output report found, rumble feedback disabled");
+  }
+}
+
+// --- Connection Statistics ---
+static void print_stats() {
+  Serial.print("*** BLE stats: attempts=");
+  Serial.print(link.stats.attempts);
+  Serial.print(" failures=");
+  Serial.print(link.stats.failures);
+  Serial.print(" connects=");
+  Serial.print(link.stats.connects);
+  if (link.stats.connects > 0) {
+    Serial.print(" reconnect ms min/avg/max=");
+    Serial.print(link.stats.minMs);
+    Serial.print("/");
+    Serial.print((unsigned long)(link.stats.totalMs / link.stats.connects));
+    Serial.print("/");
+    Serial.print(link.stats.maxMs);
+  }
+  Serial.print(" blocked=");
+  Serial.print(link.stats.blockedMs);
+  Serial.print("ms stuck(link/scan)=");
+  Serial.print(link.stats.stuckLink);
+  Serial.print("/");
+  Serial.println(link.stats.stuckScan);
+  print_rumble_stats();
+
+  Serial.print("*** BLE reconnect histogram:");
+  for (int i = 0; i < RECONNECT_BUCKET_COUNT; i++) {
+    Serial.print(" ");
+    Serial.print(reconnectBucketNames[i]);
+    Serial.print("=");
+    Serial.print(link.stats.buckets[i]);
+  }
+  Serial.println();
+}
+
 // --- D-pad press state tracking ---
 static bool dpad_up_down = false;
 static bool dpad_down_down = false;
+static bool dpad_left_down = false;
+static bool dpad_right_down = false;
 
 // --- Callback Declarations ---
 void notifyCallback(BLERemoteCharacteristic* pBLERemoteCharacteristic, uint8_t* pData, size_t length, bool isNotify);
@@ -97,7 +243,7 @@ class MyClientCallbacks : public BLEClientCallbacks {
     Serial.println("*** Note: Controller light may blink until fully paired/bonded ***");
     Serial.println("*** If you receive button data, connection is working! ***");
     Serial.println("========================================\n");
-    deviceConnected = true;
+    ble_link_connected(link);
   }
 
   void onDisconnect(BLEClient* pclient) {
@@ -105,7 +251,8 @@ class MyClientCallbacks : public BLEClientCallbacks {
     Serial.println("*** BLUETOOTH STATUS: DISCONNECTED ***");
     Serial.println("*** Xbox Controller disconnected. Will attempt to reconnect... ***");
     Serial.println("========================================\n");
-    deviceConnected = false;
+    pRumbleChar = nullptr;
+    ble_link_disconnected(link, millis());
   }
 };
 
@@ -177,8 +324,8 @@ class MyAdvertisedDeviceCallbacks: public BLEAdvertisedDeviceCallbacks {
     // Try multiple ways to identify the Xbox controller
     bool isTargetDevice = false;
     
-    // Method 1: Check by MAC address (most reliable)
-    if (advertisedDevice.getAddress().equals(targetDeviceAddress)) {
+    // Method 1: Check by MAC address of a bonded controller (most reliable)
+    if (is_bonded_address(advertisedDevice.getAddress(), advertisedDevice.getAddressType())) {
       Serial.println(">>> Found Xbox Controller by MAC ADDRESS!");
       isTargetDevice = true;
     }
@@ -199,8 +346,7 @@ class MyAdvertisedDeviceCallbacks: public BLEAdvertisedDeviceCallbacks {
     // Method 3: Check by service UUID (Xbox BLE service)
     if (!isTargetDevice && advertisedDevice.haveServiceUUID()) {
       BLEUUID advertisedServiceUUID = advertisedDevice.getServiceUUID();
-      BLEUUID xboxServiceUUID("00400000-0000-1000-8000-00805f9b34fb"); // Xbox BLE Service (0x400000)
-      if (advertisedServiceUUID.equals(xboxServiceUUID)) {
+      if (advertisedServiceUUID.equals(serviceUUID)) {
         Serial.println(">>> Found device with Xbox BLE service UUID!");
         Serial.println(">>> Attempting connection to Xbox controller...");
         isTargetDevice = true;
@@ -210,19 +356,28 @@ class MyAdvertisedDeviceCallbacks: public BLEAdvertisedDeviceCallbacks {
     if (isTargetDevice) {
       BLEDevice::getScan()->stop();
       myDevice = new BLEAdvertisedDevice(advertisedDevice);
-      doConnect = true;
+      ble_link_target_found(link, false);
     }
   }
 };
 
 // --- Main BLE Functions ---
 
-bool connectToServer() {
+// Address of the device being connected, recorded once discovery succeeds
+static uint8_t targetAddress[6];
+static uint8_t targetAddressType;
+
+static bool open_link() {
   Serial.println("\n========================================");
   Serial.println("*** BLUETOOTH: Attempting Connection ***");
+  BLEAddress target = myDevice != nullptr ? myDevice->getAddress() : *fastConnectAddress;
+  memcpy(targetAddress, *target.getNative(), sizeof(targetAddress));
+  targetAddressType = myDevice != nullptr ? myDevice->getAddressType() : fastConnectAddressType;
   Serial.print(">>> Forming a connection to ");
-  Serial.print(myDevice->getAddress().toString().c_str());
-  if (myDevice->haveName()) {
+  Serial.print(target.toString().c_str());
+  if (myDevice == nullptr) {
+    Serial.print(" (cached controller, fast resume)");
+  } else if (myDevice->haveName()) {
     Serial.print(" (");
     Serial.print(myDevice->getName().c_str());
     Serial.print(")");
@@ -233,29 +388,21 @@ bool connectToServer() {
     Serial.println(">>> Attempting BLE connection...");
   #endif
   
-  if (!pClient->connect(myDevice)) {
-    Serial.println(">>> ERROR: Failed to connect to device.");
-    Serial.println("========================================\n");
+  // The direct connect has no advertisement to confirm the controller is
+  // around, so bound it instead of waiting for the stack's default timeout.
+  bool connected = myDevice != nullptr
+      ? pClient->connect(myDevice)
+      : pClient->connect(target, targetAddressType, FAST_CONNECT_TIMEOUT_MS);
+  if (!connected) {
     return false;
   }
-  
-  Serial.println(">>> Connected! Waiting for pairing to complete...");
-  
+
   // Request MTU - this sometimes helps trigger pairing
   pClient->setMTU(517); // Request maximum MTU
-  
-  // Give time for pairing/bonding to complete
-  delay(3000);
-  
-  // Check if we're still connected after pairing attempt
-  if (!pClient->isConnected()) {
-    Serial.println(">>> ERROR: Connection lost during pairing.");
-    Serial.println(">>> This might indicate pairing failed.");
-    Serial.println("========================================\n");
-    return false;
-  }
-  
-  Serial.println(">>> Still connected, discovering services...");
+  return true;
+}
+
+static bool discover_controller() {
   Serial.println(">>> If controller light is still blinking, pairing may not have completed.");
   Serial.println(">>> Watch for 'Authentication Complete' messages above.");
 
@@ -368,11 +515,16 @@ bool connectToServer() {
     }
     
     Serial.println(">>> Successfully subscribed to Xbox controller notifications!");
+    find_rumble_characteristic(pRemoteService);
     Serial.println(">>> Xbox Controller is ready! Press D-pad UP for volume up, D-pad DOWN for volume down.");
     Serial.println(">>> Watch for 'NOTIFICATION RECEIVED' messages - if none appear, pairing may be incomplete.");
     Serial.println(">>> If controller light is blinking, pairing may still be in progress.");
     Serial.println(">>> Try pressing buttons on the controller - you should see notification messages.");
     Serial.println("========================================\n");
+    memcpy(lastAddress, targetAddress, sizeof(lastAddress));
+    lastAddressType = targetAddressType;
+    haveLastAddress = true;
+    boot_timeline_mark(BOOT_MARK_CONTROLLER);
   } else {
     Serial.println(">>> ERROR: Xbox controller characteristic does not support notifications.");
     Serial.println("========================================\n");
@@ -383,6 +535,8 @@ bool connectToServer() {
 }
 
 void notifyCallback(BLERemoteCharacteristic* pBLERemoteCharacteristic, uint8_t* pData, size_t length, bool isNotify) {
+    int64_t receivedUs = esp_timer_get_time();  // Rumble latency is measured from here
+
     // Always log that we received a notification (even if empty)
     Serial.print(">>> NOTIFICATION RECEIVED! length=");
     Serial.print(length);
@@ -422,6 +576,8 @@ void notifyCallback(BLERemoteCharacteristic* pBLERemoteCharacteristic, uint8_t*
 
     bool dpad_up_pressed_now = false;
     bool dpad_down_pressed_now = false;
+    bool dpad_left_pressed_now = false;
+    bool dpad_right_pressed_now = false;
     bool any_button_pressed = false;
     String pressed_buttons = "";
 
@@ -463,6 +619,9 @@ void notifyCallback(BLERemoteCharacteristic* pBLERemoteCharacteristic, uint8_t*
       }
       if (dpad_value == 2 || dpad_value == 3 || dpad_value == 4) pressed_buttons += "D-pad RIGHT ";
       if (dpad_value == 6 || dpad_value == 7 || dpad_value == 8) pressed_buttons += "D-pad LEFT ";
+      // Pure left/right only, so diagonals never change volume and preset together
+      dpad_right_pressed_now = (dpad_value == 3);
+      dpad_left_pressed_now = (dpad_value == 7);
       
       // Also check if it's non-zero (any direction pressed)
       if (dpad_value != 0 && !dpad_up_pressed_now && !dpad_down_pressed_now) {
@@ -519,22 +678,85 @@ void notifyCallback(BLERemoteCharacteristic* pBLERemoteCharacteristic, uint8_t*
     // Only trigger volume control on press (not release) - edge detection
     if (dpad_up_pressed_now && !dpad_up_down) {
         Serial.println(">>> D-pad UP pressed -> Volume UP");
+        int before = radio_get_volume();
         radio_increase_volume();
+        bool atLimit = radio_get_volume() == before;
+        rumble_pulse(atLimit ? RUMBLE_STRENGTH_LIMIT : RUMBLE_STRENGTH_TICK,
+                     atLimit ? RUMBLE_DURATION_LIMIT : RUMBLE_DURATION_TICK, receivedUs);
     }
     if (dpad_down_pressed_now && !dpad_down_down) {
         Serial.println(">>> D-pad DOWN pressed -> Volume DOWN");
+        int before = radio_get_volume();
         radio_decrease_volume();
+        bool atLimit = radio_get_volume() == before;
+        rumble_pulse(atLimit ? RUMBLE_STRENGTH_LIMIT : RUMBLE_STRENGTH_TICK,
+                     atLimit ? RUMBLE_DURATION_LIMIT : RUMBLE_DURATION_TICK, receivedUs);
+    }
+
+    if (dpad_right_pressed_now && !dpad_right_down) {
+        Serial.println(">>> D-pad RIGHT pressed -> Next preset");
+        radio_step_preset(1);
+        rumble_pulse(RUMBLE_STRENGTH_TICK, RUMBLE_DURATION_TICK, receivedUs);
+    }
+    if (dpad_left_pressed_now && !dpad_left_down) {
+        Serial.println(">>> D-pad LEFT pressed -> Previous preset");
+        radio_step_preset(-1);
+        rumble_pulse(RUMBLE_STRENGTH_TICK, RUMBLE_DURATION_TICK, receivedUs);
     }
 
     dpad_up_down = dpad_up_pressed_now;
     dpad_down_down = dpad_down_pressed_now;
+    dpad_left_down = dpad_left_pressed_now;
+    dpad_right_down = dpad_right_pressed_now;
 }
 
+// --- Link Driver ---
+// The real clock and BLE stack behind the connection state machine
+class ControllerLinkDriver : public BleLinkDriver {
+  unsigned long now() override { return millis(); }
+  void sleep(unsigned long ms) override { delay(ms); }
+  bool isScanning() override { return pBLEScan != nullptr && pBLEScan->isScanning(); }
+  void startScan() override {
+    if (pBLEScan != nullptr) pBLEScan->start(0, false);
+  }
+  bool openLink(bool) override { return open_link(); }
+  bool isLinkUp() override { return pClient != nullptr && pClient->isConnected(); }
+  bool discover() override { return discover_controller(); }
+  // The stale link's characteristic must not be written after a forced reset
+  void linkReset() override { pRumbleChar = nullptr; }
+
+  void attemptFinished(bool fastResume, bool) override {
+    if (myDevice != nullptr) {
+      delete myDevice;
+      myDevice = nullptr;
+    }
+    if (fastConnectAddress != nullptr) {
+      delete fastConnectAddress;
+      fastConnectAddress = nullptr;
+    }
+    if (fastResume) {
+      idle_sleep_restart_timer();
+    }
+  }
+
+  void log(const char* message) override { Serial.println(message); }
+  void printStats() override { print_stats(); }
+};
+
+static ControllerLinkDriver linkDriver;
+
 // --- Public Functions ---
 
 void ble_control_setup() {
   Serial.println("\n=== Xbox Controller Control Sketch ===");
   Serial.println("Initializing BLE...");
+
+  ble_link_reset(link, millis());
+
+  // UUIDs are stored in binary in the config image: no string parsing here
+  const RadioConfig* cfg = config_get();
+  serviceUUID = BLEUUID((uint8_t*)cfg->serviceUuid, sizeof(cfg->serviceUuid), false);
+  charUUID = BLEUUID(cfg->reportCharUuid);
   
   // Initialize BLE device
   BLEDevice::init("ESP32-Radio-Xbox");
@@ -556,6 +778,8 @@ void ble_control_setup() {
   BLEDevice::setPower(ESP_PWR_LVL_P9); 
   Serial.println(">>> BLE power set to maximum (P9)");
   
+  rumble_queue_reset(rumbleQueue);
+
   // Create BLE client
   pClient = BLEDevice::createClient();
   if (pClient == nullptr) {
@@ -580,10 +804,20 @@ void ble_control_setup() {
   pBLEScan->setActiveScan(true);
   Serial.println(">>> Active scan enabled");
   
-  pBLEScan->setInterval(1349);  // Scan interval
-  pBLEScan->setWindow(449);      // Scan window
-  Serial.println(">>> Scan parameters configured (interval: 1349ms, window: 449ms)");
+  pBLEScan->setInterval(cfg->scanIntervalMs);  // Scan interval
+  pBLEScan->setWindow(cfg->scanWindowMs);      // Scan window
+  Serial.printf(">>> Scan parameters configured (interval: %ums, window: %ums)\n",
+                cfg->scanIntervalMs, cfg->scanWindowMs);
   
+  // After a deep sleep wake, go straight to the cached controller; the loop
+  // falls back to scanning if that fails.
+  if (fastConnectAddress != nullptr) {
+    Serial.println(">>> Fast resume: skipping scan, connecting to cached controller");
+    ble_link_target_found(link, true);
+    boot_timeline_mark(BOOT_MARK_BLE_READY);
+    return;
+  }
+
   // Start scanning
   bool scanStarted = pBLEScan->start(0, false);     // 0 = continuous scan, false = don't clear results
   if (scanStarted) {
@@ -591,95 +825,53 @@ void ble_control_setup() {
   } else {
     Serial.println(">>> ERROR: Failed to start BLE scan!");
   }
+  boot_timeline_mark(BOOT_MARK_BLE_READY);
   
   Serial.println("\n========================================");
   Serial.println(">>> BLE initialized. Scanning for Xbox Controller...");
   Serial.println(">>> Make sure your Xbox controller is powered on and in pairing mode!");
   Serial.println(">>> Looking for devices with:");
   Serial.println(">>>   - Name containing 'Xbox'");
-  Serial.println(">>>   - MAC address: 44:16:22:E3:CB:B3");
+  for (int i = 0; i < cfg->bondCount; i++) {
+    const uint8_t* a = cfg->bonds[i].address;
+    Serial.printf(">>>   - MAC address: %02X:%02X:%02X:%02X:%02X:%02X\n", a[0], a[1], a[2], a[3], a[4], a[5]);
+  }
   Serial.println(">>>   - Xbox BLE service (0x400000)");
   Serial.println("========================================\n");
 }
-static unsigned long lastScanStatusTime = 0;
-static unsigned long scanStartTime = 0;
-static unsigned long lastConnectionStatusTime = 0;
-static bool lastReportedConnectionState = false;
 
 void ble_control_loop() {
-  unsigned long now = millis();
-  
-  // Report connection state changes and periodically if disconnected
-  if (deviceConnected != lastReportedConnectionState) {
-    if (deviceConnected) {
-      Serial.println("\n*** BLUETOOTH CONNECTION STATE: CONNECTED ***");
-    } else {
-      Serial.println("\n*** BLUETOOTH CONNECTION STATE: DISCONNECTED ***");
-    }
-    lastReportedConnectionState = deviceConnected;
-    lastConnectionStatusTime = now;
-  } else if (!deviceConnected && (now - lastConnectionStatusTime > 10000)) {
-    // Every 10 seconds when disconnected, show status
-    Serial.println("\n*** BLUETOOTH STATUS: DISCONNECTED - Attempting to reconnect... ***");
-    Serial.println("*** Make sure the Xbox Controller is powered on and in pairing mode ***");
-    lastConnectionStatusTime = now;
-  }
+  rumble_service();
+  ble_link_loop(link, linkDriver);
+}
 
-  if (doConnect) {
-    Serial.println("\n>>> Attempting to connect to Xbox Controller...");
-    if (connectToServer()) {
-      Serial.println(">>> Connection successful!");
-    } else {
-      Serial.println(">>> Connection failed, will re-scan...");
-      delay(1000); // Brief delay before rescanning
-    }
-    doConnect = false;
-    if (myDevice != nullptr) {
-        delete myDevice;
-        myDevice = nullptr;
-    }
-  }
+bool ble_is_connected() {
+  return link.connected;
+}
 
-  // Print periodic scan status
-  if (!deviceConnected) {
-    if (scanStartTime == 0) {
-      scanStartTime = now;
-      Serial.println("\n*** Starting BLE scan for Xbox Controller... ***");
-    }
-    
-    // Check if scan is actually running
-    bool isScanning = (pBLEScan != nullptr && pBLEScan->isScanning());
-    if (!isScanning && (now - scanStartTime > 2000)) {
-      Serial.println("\n*** WARNING: BLE scan is NOT running! Attempting to restart... ***");
-      scanStartTime = 0;
-      lastScanStatusTime = 0;
-      delay(500);
-      if (pBLEScan != nullptr) {
-        pBLEScan->start(0, false);
-      }
-    }
-    
-    if (isScanning && (now - lastScanStatusTime > 5000)) { // Every 5 seconds
-      unsigned long scanDuration = (now - scanStartTime) / 1000;
-      Serial.print("*** Still scanning for Xbox Controller... (");
-      Serial.print(scanDuration);
-      Serial.println(" seconds elapsed)");
-      Serial.println("*** Make sure Xbox Controller is powered on and in pairing mode ***");
-      Serial.println("*** If you see 'BLE SCAN WORKING' messages, scanning is active ***");
-      lastScanStatusTime = now;
-    }
-  }
+void ble_control_set_fast_connect(const uint8_t address[6], uint8_t addressType) {
+  uint8_t native[6];
+  memcpy(native, address, sizeof(native));
+  delete fastConnectAddress;
+  fastConnectAddress = new BLEAddress(native);
+  fastConnectAddressType = addressType;
+  memcpy(lastAddress, address, sizeof(lastAddress));
+  lastAddressType = addressType;
+  haveLastAddress = true;
+}
 
-  // Auto-reconnect: if disconnected and not scanning, restart scan
-  if (!deviceConnected && !pBLEScan->isScanning()) {
-    Serial.println("\n*** BLUETOOTH: Not connected and not scanning. Restarting scan... ***");
-    scanStartTime = 0;
-    lastScanStatusTime = 0;
-    delay(500);
-    pBLEScan->start(0, false);
-  }
+bool ble_get_last_address(uint8_t address[6], uint8_t* addressType) {
+  if (!haveLastAddress) return false;
+  memcpy(address, lastAddress, sizeof(lastAddress));
+  *addressType = lastAddressType;
+  return true;
 }
 
-bool ble_is_connected() {
-  return deviceConnected;
+void ble_control_stop() {
+  if (pBLEScan != nullptr && pBLEScan->isScanning()) {
+    pBLEScan->stop();
+  }
+  if (pClient != nullptr && pClient->isConnected()) {
+    pClient->disconnect();
+  }
 }
@@ -5,4 +5,13 @@ void ble_control_setup();
 void ble_control_loop();
 bool ble_is_connected();
 
+// Fast resume: connect straight to a known controller instead of scanning first.
+// addressType is the BLE address type (0 = public, 1 = random, as in ConfigBond).
+void ble_control_set_fast_connect(const uint8_t address[6], uint8_t addressType);
+// Copy the address and address type of the last successfully connected
+// controller; false if none
+bool ble_get_last_address(uint8_t address[6], uint8_t* addressType);
+// Stop scanning and drop the connection (before deep sleep)
+void ble_control_stop();
+
 #endif // BLE_CONTROL_H
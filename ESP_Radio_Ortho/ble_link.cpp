@@ -0,0 +1,185 @@
+#include "ble_link.h"
+#include <stdio.h>
+#include <string.h>
+
+const unsigned long reconnectBucketLimitMs[RECONNECT_BUCKET_COUNT - 1] = {
+  2000, 5000, 10000, 30000, 60000
+};
+const char* const reconnectBucketNames[RECONNECT_BUCKET_COUNT] = {
+  "<2s", "<5s", "<10s", "<30s", "<60s", ">=60s"
+};
+
+// delay() that is accounted for in stats.blockedMs
+static void link_delay(BleLink& link, BleLinkDriver& driver, unsigned long ms) {
+  driver.sleep(ms);
+  link.stats.blockedMs += ms;
+}
+
+static void record_connect(BleLink& link, BleLinkDriver& driver, unsigned long now) {
+  BleLinkStats& s = link.stats;
+  unsigned long elapsed = now - link.disconnectedSince;
+  s.connects++;
+  if (s.connects == 1 || elapsed < s.minMs) s.minMs = elapsed;
+  if (elapsed > s.maxMs) s.maxMs = elapsed;
+  s.totalMs += elapsed;
+  int bucket = 0;
+  while (bucket < RECONNECT_BUCKET_COUNT - 1 && elapsed >= reconnectBucketLimitMs[bucket]) {
+    bucket++;
+  }
+  s.buckets[bucket]++;
+  char line[48];
+  snprintf(line, sizeof(line), ">>> Time to (re)connect: %lu ms", elapsed);
+  driver.log(line);
+}
+
+// The connect sequence: link, pairing wait, discovery
+static bool connect_to_target(BleLink& link, BleLinkDriver& driver, bool fastResume) {
+  if (!driver.openLink(fastResume)) {
+    driver.log(">>> ERROR: Failed to connect to device.");
+    return false;
+  }
+
+  driver.log(">>> Connected! Waiting for pairing to complete...");
+  // Give time for pairing/bonding to complete
+  link_delay(link, driver, PAIRING_WAIT_MS);
+
+  // Check if we're still connected after pairing attempt
+  if (!driver.isLinkUp()) {
+    driver.log(">>> ERROR: Connection lost during pairing.");
+    driver.log(">>> This might indicate pairing failed.");
+    return false;
+  }
+
+  driver.log(">>> Still connected, discovering services...");
+  return driver.discover();
+}
+
+// --- Public Functions ---
+
+void ble_link_reset(BleLink& link, unsigned long now) {
+  memset((void*)&link, 0, sizeof(link));
+  link.disconnectedSince = now;
+  link.recoverStuckLink = true;
+}
+
+void ble_link_target_found(BleLink& link, bool fastResume) {
+  link.fastResume = fastResume;
+  link.connectPending = true;
+}
+
+void ble_link_connected(BleLink& link) {
+  link.connected = true;
+}
+
+void ble_link_disconnected(BleLink& link, unsigned long now) {
+  link.connected = false;
+  link.disconnectedSince = now;
+}
+
+void ble_link_loop(BleLink& link, BleLinkDriver& driver) {
+  unsigned long now = driver.now();
+
+  // Report connection state changes and periodically if disconnected
+  if (link.connected != link.lastReportedConnectionState) {
+    if (link.connected) {
+      driver.log("\n*** BLUETOOTH CONNECTION STATE: CONNECTED ***");
+    } else {
+      driver.log("\n*** BLUETOOTH CONNECTION STATE: DISCONNECTED ***");
+    }
+    link.lastReportedConnectionState = link.connected;
+    link.lastConnectionStatusTime = now;
+  } else if (!link.connected && (now - link.lastConnectionStatusTime > DISCONNECTED_STATUS_MS)) {
+    driver.log("\n*** BLUETOOTH STATUS: DISCONNECTED - Attempting to reconnect... ***");
+    driver.log("*** Make sure the Xbox Controller is powered on and in pairing mode ***");
+    driver.printStats();
+    link.lastConnectionStatusTime = now;
+  }
+
+  if (link.connectPending) {
+    bool fastResume = link.fastResume;
+    driver.log("\n>>> Attempting to connect to Xbox Controller...");
+    link.stats.attempts++;
+    bool connected = connect_to_target(link, driver, fastResume);
+    if (connected) {
+      driver.log(">>> Connection successful!");
+      record_connect(link, driver, driver.now());
+      driver.printStats();
+    } else {
+      driver.log(">>> Connection failed, will re-scan...");
+      link.stats.failures++;
+      link_delay(link, driver, CONNECT_RETRY_DELAY_MS);  // Brief delay before rescanning
+    }
+    link.connectPending = false;
+    link.fastResume = false;
+    driver.attemptFinished(fastResume, connected);
+    now = driver.now();
+  }
+
+  // Stuck state: the connected flag is set but the link is gone and no
+  // disconnect callback arrived. Clear the flag so the reconnect path runs.
+  if (link.connected && !driver.isLinkUp()) {
+    if (link.linkDownSince == 0) {
+      link.linkDownSince = now;
+    } else if (now - link.linkDownSince > STUCK_LINK_MS && link.recoverStuckLink) {
+      driver.log("\n*** STUCK: connected flag set but BLE link is down. Forcing reconnect... ***");
+      link.stats.stuckLink++;
+      link.connected = false;
+      link.disconnectedSince = now;
+      link.linkDownSince = 0;
+      driver.linkReset();
+    } else if (now - link.linkDownSince > STUCK_LINK_MS && !link.stuckLinkReported) {
+      driver.log("\n*** STUCK: connected flag set but BLE link is down ***");
+      link.stats.stuckLink++;
+      link.stuckLinkReported = true;
+    }
+  } else {
+    link.linkDownSince = 0;
+    link.stuckLinkReported = false;
+  }
+
+  // Stuck state: scanning for a long time without finding the controller.
+  // Only reported; the scan itself keeps running.
+  if (!link.connected && driver.isScanning() &&
+      now - link.disconnectedSince > STUCK_SCAN_MS && now - link.lastStuckScanReport > STUCK_SCAN_MS) {
+    driver.log("\n*** STUCK: no controller found after a long scan ***");
+    link.stats.stuckScan++;
+    link.lastStuckScanReport = now;
+  }
+
+  // Print periodic scan status
+  if (!link.connected) {
+    if (link.scanStartTime == 0) {
+      link.scanStartTime = now;
+      driver.log("\n*** Starting BLE scan for Xbox Controller... ***");
+    }
+
+    // Check if scan is actually running
+    bool isScanning = driver.isScanning();
+    if (!isScanning && (now - link.scanStartTime > SCAN_STALL_MS)) {
+      driver.log("\n*** WARNING: BLE scan is NOT running! Attempting to restart... ***");
+      link.scanStartTime = 0;
+      link.lastScanStatusTime = 0;
+      link_delay(link, driver, SCAN_RESTART_DELAY_MS);
+      driver.startScan();
+    }
+
+    if (isScanning && (now - link.lastScanStatusTime > SCAN_STATUS_MS)) {
+      char line[96];
+      snprintf(line, sizeof(line), "*** Still scanning for Xbox Controller... (%lu seconds elapsed)",
+               (now - link.scanStartTime) / 1000);
+      driver.log(line);
+      driver.log("*** Make sure Xbox Controller is powered on and in pairing mode ***");
+      driver.log("*** If you see 'BLE SCAN WORKING' messages, scanning is active ***");
+      link.lastScanStatusTime = now;
+    }
+  }
+
+  // Auto-reconnect: if disconnected and not scanning, restart scan
+  if (!link.connected && !driver.isScanning()) {
+    driver.log("\n*** BLUETOOTH: Not connected and not scanning. Restarting scan... ***");
+    link.scanStartTime = 0;
+    link.lastScanStatusTime = 0;
+    link_delay(link, driver, SCAN_RESTART_DELAY_MS);
+    driver.startScan();
+  }
+}
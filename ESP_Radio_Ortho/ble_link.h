@@ -0,0 +1,97 @@
+#ifndef BLE_LINK_H
+#define BLE_LINK_H
+
+#include <stdint.h>
+
+// Connection state machine for the controller link: scan, connect, pairing
+// wait, discovery, reconnect and stuck-state detection. It has no Arduino or
+// BLE library dependencies: ble_control.cpp drives it with the real stack,
+// host/ble_sim.cpp with a scripted controller on a virtual clock.
+
+// --- Timing ---
+#define PAIRING_WAIT_MS        3000    // Blocking wait for pairing/bonding after connect
+#define CONNECT_RETRY_DELAY_MS 1000    // Pause after a failed attempt before rescanning
+#define SCAN_RESTART_DELAY_MS  500     // Pause before restarting a scan that stopped
+#define SCAN_STALL_MS          2000    // Scan should be running this long after a restart
+#define DISCONNECTED_STATUS_MS 10000   // Status line while disconnected
+#define SCAN_STATUS_MS         5000    // "Still scanning" line
+
+// --- Stuck States ---
+// A stuck link (connected flag set, link down, no disconnect callback) is
+// recovered by default: the missing callback is the only way out of that
+// state, so without recovery the radio never reconnects (host/ble_sim.cpp
+// shows this for its link desync scenario). A long scan is only reported: the
+// scan is still running and connects once the controller appears.
+#define STUCK_LINK_MS 5000      // Connected flag set but the link is down
+#define STUCK_SCAN_MS 300000    // Scanning this long without a connection (reported only)
+
+// --- Connection Statistics ---
+// Time-to-reconnect distribution, time blocked in delay() and stuck-state
+// counts, so reconnect behaviour is measured rather than observed by accident.
+#define RECONNECT_BUCKET_COUNT 6
+extern const unsigned long reconnectBucketLimitMs[RECONNECT_BUCKET_COUNT - 1];
+extern const char* const reconnectBucketNames[RECONNECT_BUCKET_COUNT];
+
+struct BleLinkStats {
+  uint32_t attempts;
+  uint32_t failures;
+  uint32_t connects;
+  uint32_t buckets[RECONNECT_BUCKET_COUNT];
+  unsigned long minMs;
+  unsigned long maxMs;
+  uint64_t totalMs;
+  unsigned long blockedMs;   // Total time spent in delay() inside the BLE code
+  uint32_t stuckLink;
+  uint32_t stuckScan;
+};
+
+// What the state machine needs from the clock and the BLE stack
+class BleLinkDriver {
+ public:
+  virtual ~BleLinkDriver() {}
+  virtual unsigned long now() = 0;
+  virtual void sleep(unsigned long ms) = 0;  // Blocks the caller
+  virtual bool isScanning() = 0;
+  virtual void startScan() = 0;
+  // Connect to the pending target: the scanned device, or the cached address
+  // on a fast resume. Blocks until the link is up or the attempt failed.
+  virtual bool openLink(bool fastResume) = 0;
+  virtual bool isLinkUp() = 0;
+  // Find the controller service, subscribe to reports; disconnects on failure
+  virtual bool discover() = 0;
+  // The attempt is over: release the target
+  virtual void attemptFinished(bool fastResume, bool connected) = 0;
+  // The stuck-link check forced the connected flag down
+  virtual void linkReset() {}
+  virtual void log(const char* message) = 0;
+  virtual void printStats() {}
+};
+
+struct BleLink {
+  volatile bool connected;       // Set and cleared from the BLE task callbacks
+  volatile bool connectPending;  // A target was found, connect from the loop
+  volatile bool fastResume;      // The pending target is the cached controller
+  volatile unsigned long disconnectedSince;  // When the link last went down
+  unsigned long linkDownSince;   // Flag/link mismatch start, 0 = consistent
+  unsigned long lastStuckScanReport;
+  unsigned long scanStartTime;
+  unsigned long lastScanStatusTime;
+  unsigned long lastConnectionStatusTime;
+  bool lastReportedConnectionState;
+  bool recoverStuckLink;         // false = only report a stuck link (set after reset)
+  bool stuckLinkReported;
+  BleLinkStats stats;
+};
+
+void ble_link_reset(BleLink& link, unsigned long now);
+
+// --- Events (may be called from the BLE task) ---
+void ble_link_target_found(BleLink& link, bool fastResume);
+void ble_link_connected(BleLink& link);
+void ble_link_disconnected(BleLink& link, unsigned long now);
+
+// One pass of the main loop: connect to a pending target, check for stuck
+// states and keep the scan running while disconnected
+void ble_link_loop(BleLink& link, BleLinkDriver& driver);
+
+#endif // BLE_LINK_H
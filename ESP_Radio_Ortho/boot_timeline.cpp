@@ -0,0 +1,61 @@
+#include "boot_timeline.h"
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <esp_sleep.h>
+
+// Microseconds since reset for each milestone (0 = not reached yet).
+// esp_timer starts at reset, including after a deep sleep wake.
+static int64_t markTimeUs[BOOT_MARK_COUNT] = {0};
+
+static const char* markNames[BOOT_MARK_COUNT] = {
+  "setup", "config", "ble", "controller", "wifi", "audio"
+};
+
+static const char* wake_cause_name() {
+  switch (esp_sleep_get_wakeup_cause()) {
+    case ESP_SLEEP_WAKEUP_TIMER: return "timer";
+    case ESP_SLEEP_WAKEUP_EXT0:  return "button";
+    case ESP_SLEEP_WAKEUP_UNDEFINED: return "reset";
+    default: return "other";
+  }
+}
+
+void boot_timeline_mark(BootMark mark) {
+  if (mark >= BOOT_MARK_COUNT || markTimeUs[mark] != 0) return;
+  markTimeUs[mark] = esp_timer_get_time();
+  if (mark == BOOT_MARK_FIRST_AUDIO) {
+    boot_timeline_report();
+  }
+}
+
+void boot_timeline_report() {
+  Serial.println("\n========================================");
+  Serial.print("*** BOOT TIMELINE (wake cause: ");
+  Serial.print(wake_cause_name());
+  Serial.println(") ***");
+  int64_t previous = 0;
+  for (int i = 0; i < BOOT_MARK_COUNT; i++) {
+    Serial.print(">>>   ");
+    Serial.print(markNames[i]);
+    if (markTimeUs[i] == 0) {
+      Serial.println(": not reached");
+      continue;
+    }
+    Serial.printf(": %lu ms (+%lu ms)\n",
+                  (unsigned long)(markTimeUs[i] / 1000),
+                  (unsigned long)((markTimeUs[i] - previous) / 1000));
+    previous = markTimeUs[i];
+  }
+  Serial.println("========================================\n");
+
+  // Single line, easy to grep out of logs and compare release over release
+  Serial.print("BOOT_TIMELINE wake=");
+  Serial.print(wake_cause_name());
+  for (int i = 0; i < BOOT_MARK_COUNT; i++) {
+    Serial.print(" ");
+    Serial.print(markNames[i]);
+    Serial.print("=");
+    Serial.print((unsigned long)(markTimeUs[i] / 1000));
+  }
+  Serial.println();
+}
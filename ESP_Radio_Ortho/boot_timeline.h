@@ -0,0 +1,21 @@
+#ifndef BOOT_TIMELINE_H
+#define BOOT_TIMELINE_H
+
+// Milestones from reset to first decoded audio, in boot order
+enum BootMark {
+  BOOT_MARK_SETUP,        // setup() entered
+  BOOT_MARK_CONFIG,       // Configuration image mapped and validated
+  BOOT_MARK_BLE_READY,    // BLE stack up, scanning or fast-connecting
+  BOOT_MARK_CONTROLLER,   // Controller connected and subscribed
+  BOOT_MARK_WIFI,         // WiFi associated with an IP
+  BOOT_MARK_FIRST_AUDIO,  // First frame decoded from the stream
+  BOOT_MARK_COUNT
+};
+
+// Record a milestone (only the first call per mark counts)
+void boot_timeline_mark(BootMark mark);
+
+// Print the timeline; called automatically once first audio is marked
+void boot_timeline_report();
+
+#endif // BOOT_TIMELINE_H
@@ -0,0 +1,137 @@
+#include "config.h"
+#include "boot_timeline.h"
+#include <Arduino.h>
+#include <esp_partition.h>
+#include <esp_rom_crc.h>
+#include <esp_timer.h>
+#include <stddef.h>
+#include <string.h>
+
+#define CONFIG_PARTITION_LABEL   "radiocfg"
+#define CONFIG_PARTITION_SUBTYPE ((esp_partition_subtype_t)0x40)
+
+// --- Built-in Defaults ---
+// Used when the partition is missing or the image fails validation.
+static const RadioConfig defaultConfig = {
+  CONFIG_MAGIC,
+  CONFIG_VERSION,
+  sizeof(RadioConfig),
+  0,              // CRC is not checked for the built-in copy
+  1,              // presetCount
+  1,              // bondCount
+  0,              // defaultPreset
+  10,             // defaultVolume
+  1349,           // scanIntervalMs
+  449,            // scanWindowMs
+  "MokuMoku",
+  "h1tz31mp4rk1nb3rl1n",
+  // Xbox BLE service 00400000-0000-1000-8000-00805f9b34fb
+  {0xfb, 0x34, 0x9b, 0x5f, 0x80, 0x00, 0x00, 0x80,
+   0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x40, 0x00},
+  0x2A4D,         // Standard HID Report
+  0,
+  {
+    {"Deutschlandfunk", "https://st01.sslstream.dlf.de/dlf/01/128/mp3/stream.mp3?aggregator=web"},
+  },
+  {
+    {{0x44, 0x16, 0x22, 0xE3, 0xCB, 0xB3}, 0, 0},
+  },
+};
+
+static const RadioConfig* activeConfig = &defaultConfig;
+static esp_partition_mmap_handle_t mmapHandle;
+
+// config_setup() runs before the serial monitor can attach on a cold boot, so
+// the outcome is kept here and printed later by config_print_summary()
+static char loadProblem[96] = "";
+static unsigned long loadTimeUs = 0;
+
+// Strings are read in place, so each must end inside its field
+static bool terminated(const char* field, size_t size) {
+  return memchr(field, '\0', size) != nullptr;
+}
+
+static bool validate(const RadioConfig* cfg) {
+  if (cfg->magic != CONFIG_MAGIC) {
+    snprintf(loadProblem, sizeof(loadProblem), "no image in flash (bad magic)");
+    return false;
+  }
+  if (cfg->version != CONFIG_VERSION || cfg->size != sizeof(RadioConfig)) {
+    snprintf(loadProblem, sizeof(loadProblem), "unsupported image version %u / size %u",
+             cfg->version, cfg->size);
+    return false;
+  }
+  const uint8_t* body = (const uint8_t*)cfg + offsetof(RadioConfig, presetCount);
+  uint32_t crc = esp_rom_crc32_le(0, body, sizeof(RadioConfig) - offsetof(RadioConfig, presetCount));
+  if (crc != cfg->crc32) {
+    snprintf(loadProblem, sizeof(loadProblem), "CRC mismatch (image 0x%08lx, computed 0x%08lx)",
+             (unsigned long)cfg->crc32, (unsigned long)crc);
+    return false;
+  }
+  if (cfg->presetCount == 0 || cfg->presetCount > CONFIG_MAX_PRESETS ||
+      cfg->defaultPreset >= cfg->presetCount || cfg->bondCount > CONFIG_MAX_BONDS) {
+    snprintf(loadProblem, sizeof(loadProblem), "preset or bond count out of range");
+    return false;
+  }
+  if (cfg->scanIntervalMs < CONFIG_SCAN_MIN_MS || cfg->scanIntervalMs > CONFIG_SCAN_MAX_MS ||
+      cfg->scanWindowMs < CONFIG_SCAN_MIN_MS || cfg->scanWindowMs > cfg->scanIntervalMs) {
+    snprintf(loadProblem, sizeof(loadProblem), "scan interval/window %u/%u ms out of range",
+             cfg->scanIntervalMs, cfg->scanWindowMs);
+    return false;
+  }
+  if (!terminated(cfg->ssid, sizeof(cfg->ssid)) || !terminated(cfg->password, sizeof(cfg->password))) {
+    snprintf(loadProblem, sizeof(loadProblem), "WiFi ssid or password not NUL-terminated");
+    return false;
+  }
+  for (int i = 0; i < cfg->presetCount; i++) {
+    const ConfigPreset& preset = cfg->presets[i];
+    if (!terminated(preset.name, sizeof(preset.name)) || !terminated(preset.url, sizeof(preset.url))) {
+      snprintf(loadProblem, sizeof(loadProblem), "preset %d name or URL not NUL-terminated", i);
+      return false;
+    }
+  }
+  return true;
+}
+
+// --- Public Functions ---
+
+void config_setup() {
+  int64_t start = esp_timer_get_time();
+
+  const esp_partition_t* partition = esp_partition_find_first(
+      ESP_PARTITION_TYPE_DATA, CONFIG_PARTITION_SUBTYPE, CONFIG_PARTITION_LABEL);
+  const void* mapped = nullptr;
+  if (partition == nullptr) {
+    snprintf(loadProblem, sizeof(loadProblem), "no '" CONFIG_PARTITION_LABEL "' partition");
+  } else if (esp_partition_mmap(partition, 0, sizeof(RadioConfig), ESP_PARTITION_MMAP_DATA,
+                                &mapped, &mmapHandle) != ESP_OK) {
+    snprintf(loadProblem, sizeof(loadProblem), "failed to map partition");
+    mapped = nullptr;
+  }
+
+  // The mapping stays open for the lifetime of the firmware: callers read
+  // strings and tables straight out of flash.
+  if (mapped != nullptr && validate((const RadioConfig*)mapped)) {
+    activeConfig = (const RadioConfig*)mapped;
+  } else {
+    if (mapped != nullptr) esp_partition_munmap(mmapHandle);
+    activeConfig = &defaultConfig;
+  }
+
+  loadTimeUs = (unsigned long)(esp_timer_get_time() - start);
+  boot_timeline_mark(BOOT_MARK_CONFIG);
+}
+
+void config_print_summary() {
+  if (loadProblem[0] != '\0') {
+    Serial.print(">>> Config: ");
+    Serial.println(loadProblem);
+  }
+  Serial.printf(">>> Config: using %s (%u presets, %u bonds), loaded in %lu us\n",
+                activeConfig == &defaultConfig ? "built-in defaults" : "flash image",
+                activeConfig->presetCount, activeConfig->bondCount, loadTimeUs);
+}
+
+const RadioConfig* config_get() {
+  return activeConfig;
+}
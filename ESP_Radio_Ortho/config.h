@@ -0,0 +1,63 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <stdint.h>
+
+// --- Binary Configuration Image ---
+// Lives in the "radiocfg" flash partition (see partitions.csv) and is read in
+// place through a memory mapping: every field is fixed size and binary, so
+// boot only checks the header and CRC. Build images with tools/mkradiocfg.py;
+// its layout must match these structs exactly.
+
+#define CONFIG_MAGIC       0x47464352  // "RCFG" in little-endian byte order
+#define CONFIG_VERSION     1
+#define CONFIG_MAX_PRESETS 8
+// BLE scan interval and window limits: 0x0004-0x4000 units of 0.625 ms
+#define CONFIG_SCAN_MIN_MS 3
+#define CONFIG_SCAN_MAX_MS 10240
+#define CONFIG_MAX_BONDS   4
+
+struct ConfigPreset {
+  char name[32];
+  char url[224];
+};
+
+struct ConfigBond {
+  uint8_t address[6];       // Display order, e.g. 44:16:22:... -> {0x44, 0x16, 0x22, ...}
+  uint8_t addressType;      // 0 = public, 1 = random
+  uint8_t reserved;
+};
+
+struct RadioConfig {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t size;            // sizeof(RadioConfig)
+  uint32_t crc32;           // CRC-32 of every byte after this field
+  uint8_t presetCount;
+  uint8_t bondCount;
+  uint8_t defaultPreset;
+  uint8_t defaultVolume;    // 0-21
+  uint16_t scanIntervalMs;
+  uint16_t scanWindowMs;
+  char ssid[36];
+  char password[64];
+  uint8_t serviceUuid[16];  // Controller service UUID, least significant byte first
+  uint16_t reportCharUuid;  // HID report characteristic (16-bit UUID)
+  uint16_t reserved;
+  ConfigPreset presets[CONFIG_MAX_PRESETS];
+  ConfigBond bonds[CONFIG_MAX_BONDS];
+};
+
+static_assert(sizeof(RadioConfig) == 2220, "RadioConfig layout changed: update tools/mkradiocfg.py");
+
+// Map and validate the flash image, falling back to built-in defaults.
+// Prints nothing: the serial monitor may not be attached yet.
+void config_setup();
+
+// Print where the configuration came from and how long loading took
+void config_print_summary();
+
+// Active configuration (flash image or built-in defaults), never null
+const RadioConfig* config_get();
+
+#endif // CONFIG_H
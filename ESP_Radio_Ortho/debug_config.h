@@ -10,5 +10,50 @@
 // Enables logging for every volume change.
 #define VERBOSE_VOLUME_DEBUG 0
 
+// Enables logging of power governor decisions and clock residency.
+#define VERBOSE_POWER_DEBUG 0
+
+// Prints a "time_ms,link_kbps" throughput sample every POWER_EVAL_INTERVAL_MS
+// for host/power_sim; a serial capture can be replayed as is. Holds modem sleep
+// at MIN while tracing so the samples describe the link, not the governor.
+#define POWER_TRACE 0
+
+// Enables DSP configuration logs and a periodic cycles-per-frame benchmark.
+#define VERBOSE_DSP_DEBUG 0
+
+// Prints a SOAK line (underruns, reconnects, heap low-water, fragmentation
+// and drift since the first sample) every SOAK_REPORT_INTERVAL_MS.
+#define SOAK_TELEMETRY 0
+#define SOAK_REPORT_INTERVAL_MS 60000
+
+// --- IDLE SLEEP ---
+// Deep sleep after IDLE_SLEEP_TIMEOUT_MS without a controller or audio. A timer
+// wake only scans for IDLE_RESCAN_TIMEOUT_MS (about 4% awake with no
+// controller around). A BOOT button wake connects straight to the cached
+// controller, bounded by FAST_CONNECT_TIMEOUT_MS, then gets the full timeout.
+#define IDLE_SLEEP_TIMEOUT_MS   120000
+#define IDLE_RESCAN_TIMEOUT_MS  5000
+#define IDLE_WAKE_INTERVAL_S    120
+#define FAST_CONNECT_TIMEOUT_MS 5000
+
+// Uncomment to play from another server, e.g. a local test stream for soak runs.
+// #define STREAM_URL_OVERRIDE "http://192.168.1.10:8000/stream.mp3"
+
+// --- BENCHMARK FLAGS ---
+// Set PIPELINE_BENCHMARK to 1 to start the radio at boot without a controller
+// and decode PIPELINE_BENCHMARK_FILE from LittleFS instead of the stream.
+// Real-time factor, CPU per second of audio and heap usage are printed at EOF.
+#define PIPELINE_BENCHMARK 0
+#define PIPELINE_BENCHMARK_FILE "/bench.mp3"
+// 1 = discard decoded audio instead of writing it to I2S (decode runs unthrottled)
+#define PIPELINE_BENCHMARK_NULL_SINK 1
+// Uncomment to benchmark a network stream instead, e.g. tools/icy_server.py
+// --file 128=bench.mp3 --script tools/bench_jitter.txt. WiFi and prebuffering
+// are then in the path, output always goes to I2S so the buffer drains in real
+// time, and the report adds prebuffer stalls and underruns. The run ends after
+// PIPELINE_BENCHMARK_SECONDS.
+// #define PIPELINE_BENCHMARK_URL "http://192.168.1.10:8000/bench.mp3"
+#define PIPELINE_BENCHMARK_SECONDS 120
+
 
 #endif // DEBUG_CONFIG_H
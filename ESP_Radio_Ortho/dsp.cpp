@@ -0,0 +1,351 @@
+#include "dsp.h"
+#include "debug_config.h"
+#include <Arduino.h>
+#include <math.h>
+
+// --- EQ Kernel ---
+// The S3 runs the EQ through esp-dsp (bundled with arduino-esp32 3.x), whose
+// dsps_biquad_f32 resolves to the hand-written aes3 kernel for the S3's FPU and
+// zero-overhead loops. Other targets, and cores built without esp-dsp, use the
+// fixed-point cascade below. The host tests build both (host/Makefile sets
+// DSP_USE_ESP_DSP for the esp-dsp variant).
+#ifndef DSP_USE_ESP_DSP
+  #if defined(CONFIG_IDF_TARGET_ESP32S3) && __has_include(<dsps_biquad.h>)
+    #define DSP_USE_ESP_DSP 1
+  #else
+    #define DSP_USE_ESP_DSP 0
+  #endif
+#endif
+#if DSP_USE_ESP_DSP
+#include <dsps_biquad.h>
+#endif
+
+// --- EQ Configuration ---
+// Tuned for the small full-range speaker on the MAX98357: roll off what the
+// driver cannot reproduce, tame the upper bass that makes it distort, and
+// lift the presence range a little so speech stays clear at low volume.
+enum DspFilterType {
+  DSP_HIGH_PASS,
+  DSP_LOW_SHELF,
+  DSP_PEAKING,
+  DSP_HIGH_SHELF,
+};
+
+struct DspBand {
+  DspFilterType type;
+  float freqHz;
+  float gainDb;   // Ignored for high pass
+  float q;
+};
+
+static const DspBand eqBands[] = {
+  {DSP_HIGH_PASS,   90.0f,  0.0f, 0.707f},
+  {DSP_LOW_SHELF,  250.0f, -5.0f, 0.707f},
+  {DSP_PEAKING,   3000.0f,  2.0f, 1.0f},
+  {DSP_HIGH_SHELF, 9000.0f, -2.0f, 0.707f},
+};
+#define EQ_BAND_COUNT (sizeof(eqBands) / sizeof(eqBands[0]))
+
+// --- Limiter Configuration ---
+#define LIMITER_THRESHOLD    29204  // -1 dBFS in 16-bit full scale
+#define LIMITER_LOOKAHEAD    64     // Frames of delay (~1.5 ms at 44.1 kHz), power of two
+#define LIMITER_RELEASE_SHIFT 12    // Envelope decay once the peak has passed, ~90 ms at 44.1 kHz
+
+// --- Fixed-point Formats ---
+// Samples run at Q23 inside the chain (16-bit PCM << 8) so the filters keep
+// precision below the output LSB; coefficients are Q28, giving a range of
+// +/-8 which covers every RBJ coefficient for the gains used here.
+#define SAMPLE_SHIFT 8
+#define COEF_SHIFT   28
+#define GAIN_ONE     (1 << 16)      // Limiter gain, Q16
+
+#define DSP_MAX_CHANNELS 2
+#define DSP_BLOCK_FRAMES 128
+
+struct BandDesign {
+  double b0, b1, b2, a1, a2;  // a0 normalised to 1
+};
+
+static uint32_t dspSampleRate = 0;
+
+#if DSP_USE_ESP_DSP
+// esp-dsp's kernel is direct form II, whose state grows far above the signal
+// for the low-frequency poles here and loses precision in float. Each band is
+// therefore run as direct form I in two calls, zeros then poles, so the state
+// of the pole stage is the band's output. Layout per stage: {b0, b1, b2, a1, a2}
+// and two words of state.
+static float zeroCoefs[EQ_BAND_COUNT][5];
+static float poleCoefs[EQ_BAND_COUNT][5];
+static float state[EQ_BAND_COUNT][DSP_MAX_CHANNELS][2][2];  // [band][channel][zero/pole stage]
+static float floatWork[2][DSP_BLOCK_FRAMES] __attribute__((aligned(16)));
+#else
+struct BiquadCoefs {
+  int32_t b0, b1, b2, a1, a2;  // a0 normalised to 1
+};
+
+struct BiquadState {
+  int32_t x1, x2, y1, y2;
+};
+
+static BiquadCoefs coefs[EQ_BAND_COUNT];
+static BiquadState state[EQ_BAND_COUNT][DSP_MAX_CHANNELS];
+#endif
+
+// Per-channel working block, de-interleaved
+static int32_t work[DSP_MAX_CHANNELS][DSP_BLOCK_FRAMES];
+
+// Limiter state (gain is linked across channels)
+static int32_t delayLine[DSP_MAX_CHANNELS][LIMITER_LOOKAHEAD];
+static uint32_t delayPos = 0;
+static int32_t envelope = 0;
+
+// Sliding maximum of the frame peaks still in the delay line, as a monotonic
+// queue: values decrease from head to tail, so the head is the window peak.
+#define PEAK_QUEUE_SLOTS (2 * LIMITER_LOOKAHEAD)
+static int32_t peakValue[PEAK_QUEUE_SLOTS];
+static uint32_t peakFrame[PEAK_QUEUE_SLOTS];
+static uint32_t peakHead = 0;
+static uint32_t peakTail = 0;
+static uint32_t frameCounter = 0;
+
+// Target gains of the last LIMITER_LOOKAHEAD frames and their sum: the applied
+// gain is their average, a linear ramp across the lookahead
+static int32_t gainHistory[LIMITER_LOOKAHEAD];
+static int32_t gainSum = 0;
+
+#if VERBOSE_DSP_DEBUG
+static uint64_t benchCycles = 0;
+static uint32_t benchFrames = 0;
+static unsigned long lastBenchReport = 0;
+#endif
+
+// RBJ audio EQ cookbook designs, computed in double and quantised once per kernel
+static BandDesign design_band(const DspBand& band, uint32_t sampleRate) {
+  double A = pow(10.0, band.gainDb / 40.0);
+  double w0 = 2.0 * M_PI * band.freqHz / sampleRate;
+  double cosw = cos(w0);
+  double alpha = sin(w0) / (2.0 * band.q);
+  double b0, b1, b2, a0, a1, a2;
+
+  switch (band.type) {
+    case DSP_HIGH_PASS:
+      b0 = (1.0 + cosw) / 2.0;
+      b1 = -(1.0 + cosw);
+      b2 = (1.0 + cosw) / 2.0;
+      a0 = 1.0 + alpha;
+      a1 = -2.0 * cosw;
+      a2 = 1.0 - alpha;
+      break;
+    case DSP_LOW_SHELF: {
+      double sq = 2.0 * sqrt(A) * alpha;
+      b0 = A * ((A + 1.0) - (A - 1.0) * cosw + sq);
+      b1 = 2.0 * A * ((A - 1.0) - (A + 1.0) * cosw);
+      b2 = A * ((A + 1.0) - (A - 1.0) * cosw - sq);
+      a0 = (A + 1.0) + (A - 1.0) * cosw + sq;
+      a1 = -2.0 * ((A - 1.0) + (A + 1.0) * cosw);
+      a2 = (A + 1.0) + (A - 1.0) * cosw - sq;
+      break;
+    }
+    case DSP_HIGH_SHELF: {
+      double sq = 2.0 * sqrt(A) * alpha;
+      b0 = A * ((A + 1.0) + (A - 1.0) * cosw + sq);
+      b1 = -2.0 * A * ((A - 1.0) + (A + 1.0) * cosw);
+      b2 = A * ((A + 1.0) + (A - 1.0) * cosw - sq);
+      a0 = (A + 1.0) - (A - 1.0) * cosw + sq;
+      a1 = 2.0 * ((A - 1.0) - (A + 1.0) * cosw);
+      a2 = (A + 1.0) - (A - 1.0) * cosw - sq;
+      break;
+    }
+    case DSP_PEAKING:
+    default:
+      b0 = 1.0 + alpha * A;
+      b1 = -2.0 * cosw;
+      b2 = 1.0 - alpha * A;
+      a0 = 1.0 + alpha / A;
+      a1 = -2.0 * cosw;
+      a2 = 1.0 - alpha / A;
+      break;
+  }
+
+  return BandDesign{b0 / a0, b1 / a0, b2 / a0, a1 / a0, a2 / a0};
+}
+
+#if DSP_USE_ESP_DSP
+static void set_band(size_t b, const BandDesign& d) {
+  const float zeros[5] = {(float)d.b0, (float)d.b1, (float)d.b2, 0.0f, 0.0f};
+  const float poles[5] = {1.0f, 0.0f, 0.0f, (float)d.a1, (float)d.a2};
+  memcpy(zeroCoefs[b], zeros, sizeof(zeros));
+  memcpy(poleCoefs[b], poles, sizeof(poles));
+}
+
+// One channel through the cascade in float, back into work[] at Q23 for the
+// limiter. Each band reads and ends in floatWork[0].
+static void eq_channel(const int16_t* samples, uint32_t n, uint8_t channels, uint8_t ch) {
+  float* in = floatWork[0];
+  float* out = floatWork[1];
+  for (uint32_t i = 0; i < n; i++) {
+    in[i] = (float)((int32_t)samples[i * channels + ch] << SAMPLE_SHIFT);
+  }
+  for (size_t b = 0; b < EQ_BAND_COUNT; b++) {
+    dsps_biquad_f32(in, out, (int)n, zeroCoefs[b], state[b][ch][0]);
+    dsps_biquad_f32(out, in, (int)n, poleCoefs[b], state[b][ch][1]);
+  }
+  for (uint32_t i = 0; i < n; i++) {
+    work[ch][i] = (int32_t)lrintf(in[i]);
+  }
+}
+#else
+static int32_t to_q28(double value) {
+  return (int32_t)lround(value * (double)(1 << COEF_SHIFT));
+}
+
+static void set_band(size_t b, const BandDesign& d) {
+  coefs[b].b0 = to_q28(d.b0);
+  coefs[b].b1 = to_q28(d.b1);
+  coefs[b].b2 = to_q28(d.b2);
+  coefs[b].a1 = to_q28(d.a1);
+  coefs[b].a2 = to_q28(d.a2);
+}
+
+// Direct form I over one channel of a block. Coefficients and state stay in
+// locals for the whole block so the inner loop is pure multiply-accumulate.
+static void biquad_block(int32_t* x, uint32_t n, const BiquadCoefs& c, BiquadState& s) {
+  const int64_t b0 = c.b0, b1 = c.b1, b2 = c.b2, a1 = c.a1, a2 = c.a2;
+  int32_t x1 = s.x1, x2 = s.x2, y1 = s.y1, y2 = s.y2;
+  for (uint32_t i = 0; i < n; i++) {
+    int32_t in = x[i];
+    int64_t acc = b0 * in + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+    int32_t out = (int32_t)((acc + (1LL << (COEF_SHIFT - 1))) >> COEF_SHIFT);
+    x2 = x1; x1 = in;
+    y2 = y1; y1 = out;
+    x[i] = out;
+  }
+  s.x1 = x1; s.x2 = x2; s.y1 = y1; s.y2 = y2;
+}
+
+static void eq_channel(const int16_t* samples, uint32_t n, uint8_t channels, uint8_t ch) {
+  for (uint32_t i = 0; i < n; i++) {
+    work[ch][i] = (int32_t)samples[i * channels + ch] << SAMPLE_SHIFT;
+  }
+  for (size_t b = 0; b < EQ_BAND_COUNT; b++) {
+    biquad_block(work[ch], n, coefs[b], state[b][ch]);
+  }
+}
+#endif
+
+static inline int16_t saturate16(int32_t v) {
+  if (v > 32767) return 32767;
+  if (v < -32768) return -32768;
+  return (int16_t)v;
+}
+
+// Linked-gain peak limiter. The envelope holds the largest peak in the
+// lookahead window and releases slowly after it; its target gain is then
+// averaged over the last LIMITER_LOOKAHEAD frames. Every target in that
+// average was computed while the sample now leaving the delay line was inside
+// the window, so the average never exceeds the gain that sample needs, and
+// the gain moves by at most 1/LIMITER_LOOKAHEAD of full scale per frame.
+static void limiter_block(int16_t* out, uint32_t n, uint8_t channels) {
+  const int32_t threshold = (int32_t)LIMITER_THRESHOLD << SAMPLE_SHIFT;
+  for (uint32_t i = 0; i < n; i++) {
+    int32_t peak = 0;
+    for (uint8_t ch = 0; ch < channels; ch++) {
+      int32_t v = work[ch][i];
+      if (v < 0) v = -v;
+      if (v > peak) peak = v;
+    }
+
+    // Window covers this frame and the LIMITER_LOOKAHEAD frames in the delay line
+    while (peakTail != peakHead && peakValue[(peakTail - 1) & (PEAK_QUEUE_SLOTS - 1)] <= peak) {
+      peakTail--;
+    }
+    peakValue[peakTail & (PEAK_QUEUE_SLOTS - 1)] = peak;
+    peakFrame[peakTail & (PEAK_QUEUE_SLOTS - 1)] = frameCounter;
+    peakTail++;
+    if (frameCounter - peakFrame[peakHead & (PEAK_QUEUE_SLOTS - 1)] > LIMITER_LOOKAHEAD) {
+      peakHead++;
+    }
+    frameCounter++;
+    int32_t windowPeak = peakValue[peakHead & (PEAK_QUEUE_SLOTS - 1)];
+
+    envelope -= envelope >> LIMITER_RELEASE_SHIFT;
+    if (envelope < windowPeak) envelope = windowPeak;
+
+    int32_t target = GAIN_ONE;
+    if (envelope > threshold) {
+      target = (int32_t)(((int64_t)threshold << 16) / envelope);
+    }
+    gainSum += target - gainHistory[delayPos];
+    gainHistory[delayPos] = target;
+    int32_t gain = gainSum / LIMITER_LOOKAHEAD;
+
+    for (uint8_t ch = 0; ch < channels; ch++) {
+      int32_t delayed = delayLine[ch][delayPos];
+      delayLine[ch][delayPos] = work[ch][i];
+      int32_t v = (int32_t)(((int64_t)delayed * gain) >> 16);
+      out[i * channels + ch] = saturate16((v + (1 << (SAMPLE_SHIFT - 1))) >> SAMPLE_SHIFT);
+    }
+    delayPos = (delayPos + 1) & (LIMITER_LOOKAHEAD - 1);
+  }
+}
+
+// --- Public Functions ---
+
+void dsp_setup(uint32_t sampleRate) {
+  if (sampleRate == 0) return;
+  dspSampleRate = sampleRate;
+  for (size_t b = 0; b < EQ_BAND_COUNT; b++) {
+    set_band(b, design_band(eqBands[b], sampleRate));
+  }
+  memset(state, 0, sizeof(state));
+  memset(delayLine, 0, sizeof(delayLine));
+  delayPos = 0;
+  envelope = 0;
+  peakHead = 0;
+  peakTail = 0;
+  frameCounter = 0;
+  for (uint32_t i = 0; i < LIMITER_LOOKAHEAD; i++) gainHistory[i] = GAIN_ONE;
+  gainSum = GAIN_ONE * LIMITER_LOOKAHEAD;
+  #if VERBOSE_DSP_DEBUG
+    Serial.print("*** DSP configured for ");
+    Serial.print(sampleRate);
+    Serial.print(" Hz, ");
+    Serial.print(EQ_BAND_COUNT);
+    Serial.println(DSP_USE_ESP_DSP ? " EQ bands (esp-dsp) + limiter" : " EQ bands + limiter");
+  #endif
+}
+
+void dsp_process(int16_t* samples, uint32_t frames, uint8_t channels) {
+  if (dspSampleRate == 0 || channels == 0 || channels > DSP_MAX_CHANNELS) return;
+
+  #if VERBOSE_DSP_DEBUG
+    uint32_t startCycles = ESP.getCycleCount();
+    benchFrames += frames;
+  #endif
+
+  while (frames > 0) {
+    uint32_t n = frames < DSP_BLOCK_FRAMES ? frames : DSP_BLOCK_FRAMES;
+
+    for (uint8_t ch = 0; ch < channels; ch++) {
+      eq_channel(samples, n, channels, ch);
+    }
+    limiter_block(samples, n, channels);
+
+    samples += n * channels;
+    frames -= n;
+  }
+
+  #if VERBOSE_DSP_DEBUG
+    benchCycles += ESP.getCycleCount() - startCycles;
+    if (millis() - lastBenchReport > 10000 && benchFrames > 0) {
+      Serial.print("*** DSP: ");
+      Serial.print((uint32_t)(benchCycles / benchFrames));
+      Serial.print(" cycles/frame at ");
+      Serial.print(getCpuFrequencyMhz());
+      Serial.println(" MHz");
+      benchCycles = 0;
+      benchFrames = 0;
+      lastBenchReport = millis();
+    }
+  #endif
+}
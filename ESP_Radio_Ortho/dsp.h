@@ -0,0 +1,18 @@
+#ifndef DSP_H
+#define DSP_H
+
+#include <stdint.h>
+
+// Post-decode processing for the MAX98357 speaker: a cascade of biquad EQ
+// bands followed by a fixed-point lookahead peak limiter. On the S3 the EQ
+// runs on esp-dsp's optimised biquad kernel, elsewhere in fixed point.
+// host/dsp_test.cpp checks both against a double-precision reference and
+// host/dsp_bench.cpp measures cycles per frame.
+
+// (Re)compute filter coefficients for a sample rate and reset filter state
+void dsp_setup(uint32_t sampleRate);
+
+// Process interleaved 16-bit PCM in place
+void dsp_process(int16_t* samples, uint32_t frames, uint8_t channels);
+
+#endif // DSP_H
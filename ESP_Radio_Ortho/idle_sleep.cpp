@@ -0,0 +1,108 @@
+#include "idle_sleep.h"
+#include "radio.h"
+#include "ble_control.h"
+#include "debug_config.h"
+#include <Arduino.h>
+#include <esp_sleep.h>
+#include <driver/rtc_io.h>
+
+// --- Idle Sleep Configuration ---
+// Timeouts are in debug_config.h
+#define WAKE_BUTTON_PIN GPIO_NUM_0  // XIAO ESP32S3 BOOT button, active low
+
+// --- State kept in RTC memory across deep sleep ---
+#define RTC_STATE_MAGIC 0x52414433  // "RAD3"
+
+struct RtcState {
+  uint32_t magic;
+  uint32_t sleepCount;
+  int volume;
+  int preset;
+  bool playing;
+  bool haveController;
+  uint8_t controllerAddress[6];
+  uint8_t controllerAddressType;  // 0 = public, 1 = random
+};
+
+RTC_DATA_ATTR static RtcState rtcState;
+
+static bool resumedFromSleep = false;
+static unsigned long idleSince = 0;
+static bool controllerSeen = false;
+
+static void enter_deep_sleep() {
+  rtcState.magic = RTC_STATE_MAGIC;
+  rtcState.sleepCount++;
+  rtcState.volume = radio_get_volume();
+  rtcState.preset = radio_get_preset();
+  rtcState.playing = radio_is_playing();
+  // Keep the previous address if this session never connected
+  if (ble_get_last_address(rtcState.controllerAddress, &rtcState.controllerAddressType)) {
+    rtcState.haveController = true;
+  }
+
+  Serial.println("\n========================================");
+  Serial.println("*** IDLE: No controller connected. Entering deep sleep... ***");
+  Serial.print("*** Wake on BOOT button or in ");
+  Serial.print(IDLE_WAKE_INTERVAL_S);
+  Serial.println(" seconds ***");
+  Serial.println("========================================\n");
+  Serial.flush();
+
+  ble_control_stop();
+
+  esp_sleep_enable_timer_wakeup((uint64_t)IDLE_WAKE_INTERVAL_S * 1000000ULL);
+  rtc_gpio_pullup_en(WAKE_BUTTON_PIN);
+  rtc_gpio_pulldown_dis(WAKE_BUTTON_PIN);
+  esp_sleep_enable_ext0_wakeup(WAKE_BUTTON_PIN, 0);
+  esp_deep_sleep_start();
+}
+
+// --- Public Functions ---
+
+bool idle_sleep_setup() {
+  esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
+  resumedFromSleep = (cause == ESP_SLEEP_WAKEUP_TIMER || cause == ESP_SLEEP_WAKEUP_EXT0) &&
+                     rtcState.magic == RTC_STATE_MAGIC;
+  idleSince = millis();
+
+  if (!resumedFromSleep) {
+    memset(&rtcState, 0, sizeof(rtcState));
+    return false;
+  }
+
+  Serial.print("\n*** Resumed from deep sleep #");
+  Serial.print(rtcState.sleepCount);
+  Serial.println(cause == ESP_SLEEP_WAKEUP_EXT0 ? " (button) ***" : " (timer) ***");
+
+  radio_restore_state(rtcState.volume, rtcState.playing, rtcState.preset);
+  // Only a button wake connects directly. On a timer wake the scan finds a
+  // powered-on controller anyway, and a switched-off one would cost the full
+  // connect timeout on every wake.
+  if (rtcState.haveController && cause == ESP_SLEEP_WAKEUP_EXT0) {
+    ble_control_set_fast_connect(rtcState.controllerAddress, rtcState.controllerAddressType);
+  }
+  return true;
+}
+
+void idle_sleep_restart_timer() {
+  idleSince = millis();
+}
+
+void idle_sleep_loop(bool audioActive) {
+  unsigned long now = millis();
+  if (ble_is_connected() || audioActive) {
+    controllerSeen = controllerSeen || ble_is_connected();
+    idleSince = now;
+    return;
+  }
+
+  // A timer wake is only a quick look for the controller. A button wake, or a
+  // controller that connected and left again, gets the full timeout.
+  bool quickRescan = resumedFromSleep && !controllerSeen &&
+                     esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER;
+  unsigned long timeout = quickRescan ? IDLE_RESCAN_TIMEOUT_MS : IDLE_SLEEP_TIMEOUT_MS;
+  if (now - idleSince > timeout) {
+    enter_deep_sleep();
+  }
+}
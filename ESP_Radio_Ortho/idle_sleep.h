@@ -0,0 +1,16 @@
+#ifndef IDLE_SLEEP_H
+#define IDLE_SLEEP_H
+
+// Check the wake cause and, after a sleep wake, restore the cached
+// radio and controller state. Returns true if we resumed from sleep.
+bool idle_sleep_setup();
+
+// Start the idle window again, e.g. once the blocking fast-resume connect
+// attempt is over, so the time it took does not count as idle.
+void idle_sleep_restart_timer();
+
+// Enter deep sleep once no controller has been connected and no audio
+// has been playing for the configured idle timeout.
+void idle_sleep_loop(bool audioActive);
+
+#endif // IDLE_SLEEP_H
@@ -0,0 +1,115 @@
+#include "power.h"
+#include "power_policy.h"
+#include "radio.h"
+#include "debug_config.h"
+#include <Arduino.h>
+#include <WiFi.h>
+
+// --- Governor State ---
+// The decision lives in power_policy.cpp; this file applies it to the hardware.
+static PowerPolicy policy;
+static int appliedStep = -1;
+static bool appliedModemDeepSleep = false;
+static unsigned long lastEvalTime = 0;
+
+// Time spent at each clock step, for the periodic residency report
+static unsigned long residencyMs[POWER_CPU_STEP_COUNT] = {0};
+static unsigned long lastReportTime = 0;
+
+#if POWER_TRACE
+// --- Throughput Trace ---
+// Link throughput is estimated as the change in buffered bytes plus what the
+// decoder consumed at the stream bitrate. The reader pauses while the buffer
+// is full, so samples then show the stream rate, not the link's capacity.
+static unsigned long traceStartTime = 0;
+static uint32_t traceLastBuffered = 0;
+
+static void trace_sample(unsigned long now, unsigned long elapsedMs) {
+  uint32_t buffered = radio_get_buffer_bytes();
+  double consumed = radio_is_playing() ? radio_get_bitrate() / 8.0 * elapsedMs / 1000.0 : 0.0;
+  double received = (double)buffered - (double)traceLastBuffered + consumed;
+  traceLastBuffered = buffered;
+  if (received < 0) received = 0;  // Bitrate estimate ran ahead of the decoder
+  Serial.printf("%lu,%.1f\n", now - traceStartTime, received * 8.0 / elapsedMs);
+}
+#endif
+
+static void apply_cpu_step(int step) {
+  if (step == appliedStep) return;
+  appliedStep = step;
+  setCpuFrequencyMhz(powerCpuStepsMhz[step]);
+  #if VERBOSE_POWER_DEBUG
+    Serial.print("*** Power: CPU -> ");
+    Serial.print(powerCpuStepsMhz[step]);
+    Serial.println(" MHz");
+  #endif
+}
+
+static void apply_modem_sleep(bool deep) {
+  if (deep == appliedModemDeepSleep) return;
+  appliedModemDeepSleep = deep;
+  // WiFi and BLE share the radio, so modem sleep must stay enabled in some
+  // form: we only switch between minimum and maximum modem sleep.
+  WiFi.setSleep(deep ? WIFI_PS_MAX_MODEM : WIFI_PS_MIN_MODEM);
+  #if VERBOSE_POWER_DEBUG
+    Serial.print("*** Power: modem sleep -> ");
+    Serial.println(deep ? "MAX" : "MIN");
+  #endif
+}
+
+// --- Public Functions ---
+
+void power_setup() {
+  power_policy_reset(policy);
+  appliedStep = -1;
+  apply_cpu_step(policy.cpuStep);
+  appliedModemDeepSleep = policy.modemDeepSleep;
+  WiFi.setSleep(WIFI_PS_MIN_MODEM);
+  lastEvalTime = millis();
+  lastReportTime = lastEvalTime;
+  Serial.println(">>> Power governor started (CPU 240 MHz, modem sleep MIN)");
+  #if POWER_TRACE
+    traceStartTime = lastEvalTime;
+    traceLastBuffered = radio_get_buffer_bytes();
+    Serial.println("# power trace: time_ms,link_kbps");
+  #endif
+}
+
+void power_loop() {
+  unsigned long now = millis();
+  if (now - lastEvalTime < POWER_EVAL_INTERVAL_MS) return;
+  residencyMs[appliedStep] += now - lastEvalTime;
+  #if POWER_TRACE
+    trace_sample(now, now - lastEvalTime);
+  #endif
+  lastEvalTime = now;
+
+  int fill = radio_get_buffer_fill();
+  int load = radio_get_decode_load();
+
+  power_policy_step(policy, radio_is_playing(), fill, load);
+  apply_cpu_step(policy.cpuStep);
+  // The trace must describe the link, not the governor's modem throttling
+  apply_modem_sleep(POWER_TRACE ? false : policy.modemDeepSleep);
+
+  #if VERBOSE_POWER_DEBUG
+    if (now - lastReportTime > 30000) {
+      unsigned long total = 0;
+      for (int i = 0; i < POWER_CPU_STEP_COUNT; i++) total += residencyMs[i];
+      Serial.print("*** Power: buffer ");
+      Serial.print(fill);
+      Serial.print("% load ");
+      Serial.print(load);
+      Serial.print("% residency");
+      for (int i = 0; i < POWER_CPU_STEP_COUNT; i++) {
+        Serial.print(" ");
+        Serial.print(powerCpuStepsMhz[i]);
+        Serial.print("MHz=");
+        Serial.print(total >= 100 ? residencyMs[i] / (total / 100) : 0);
+        Serial.print("%");
+      }
+      Serial.println();
+      lastReportTime = now;
+    }
+  #endif
+}
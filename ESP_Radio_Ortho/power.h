@@ -0,0 +1,10 @@
+#ifndef POWER_H
+#define POWER_H
+
+// Start the power governor (call once the radio is running)
+void power_setup();
+
+// Re-evaluate CPU frequency and WiFi modem sleep from buffer fill and decode load
+void power_loop();
+
+#endif // POWER_H
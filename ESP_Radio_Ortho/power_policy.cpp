@@ -0,0 +1,35 @@
+#include "power_policy.h"
+
+const unsigned int powerCpuStepsMhz[POWER_CPU_STEP_COUNT] = {80, 160, 240};
+
+void power_policy_reset(PowerPolicy& policy) {
+  policy.cpuStep = POWER_CPU_STEP_COUNT - 1;
+  policy.modemDeepSleep = false;
+  policy.relaxedEvals = 0;
+}
+
+void power_policy_step(PowerPolicy& policy, bool playing, int fillPercent, int loadPercent) {
+  if (!playing) {
+    // Nothing to decode: only BLE input needs servicing.
+    policy.relaxedEvals = 0;
+    policy.cpuStep = 0;
+    policy.modemDeepSleep = true;
+  } else if (fillPercent < BUFFER_LOW_PERCENT) {
+    // Buffer is draining: fetch and decode as fast as possible.
+    policy.relaxedEvals = 0;
+    policy.cpuStep = POWER_CPU_STEP_COUNT - 1;
+    policy.modemDeepSleep = false;
+  } else if (loadPercent > LOAD_HIGH_PERCENT) {
+    policy.relaxedEvals = 0;
+    if (policy.cpuStep < POWER_CPU_STEP_COUNT - 1) policy.cpuStep++;
+  } else if (fillPercent > BUFFER_HIGH_PERCENT && loadPercent < LOAD_LOW_PERCENT) {
+    // Comfortably ahead: step down one notch at a time, with hysteresis.
+    policy.modemDeepSleep = true;
+    if (++policy.relaxedEvals >= STEP_DOWN_HOLD_EVALS) {
+      policy.relaxedEvals = 0;
+      if (policy.cpuStep > 0) policy.cpuStep--;
+    }
+  } else {
+    policy.relaxedEvals = 0;
+  }
+}
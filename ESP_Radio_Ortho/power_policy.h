@@ -0,0 +1,36 @@
+#ifndef POWER_POLICY_H
+#define POWER_POLICY_H
+
+// Decision logic of the power governor. It has no Arduino dependencies so the
+// host simulator (host/power_sim.cpp) replays throughput traces through
+// exactly the code that runs on the device.
+
+// --- Governor Configuration ---
+// A 128 kbit/s MP3 stream needs only a fraction of the S3 at 240 MHz, so we
+// run slow and let the modem sleep while the input buffer is comfortably full,
+// and boost as soon as it starts to drain.
+#define POWER_EVAL_INTERVAL_MS 500
+#define BUFFER_LOW_PERCENT     30  // Below this: boost to full clock, light modem sleep
+#define BUFFER_HIGH_PERCENT    70  // Above this: allowed to step down
+#define LOAD_HIGH_PERCENT      60  // Decode load (at current clock) that forces a step up
+#define LOAD_LOW_PERCENT       25  // Decode load below which a step down is safe
+#define STEP_DOWN_HOLD_EVALS   4   // Consecutive relaxed evaluations before stepping down
+
+// 80 MHz is the lowest clock that keeps WiFi running.
+#define POWER_CPU_STEP_COUNT 3
+extern const unsigned int powerCpuStepsMhz[POWER_CPU_STEP_COUNT];
+
+struct PowerPolicy {
+  int cpuStep;          // Index into powerCpuStepsMhz
+  bool modemDeepSleep;  // true = WIFI_PS_MAX_MODEM, false = WIFI_PS_MIN_MODEM
+  int relaxedEvals;
+};
+
+// Full clock, minimum modem sleep
+void power_policy_reset(PowerPolicy& policy);
+
+// One evaluation: update the target clock step and modem sleep mode from
+// buffer fill and decode load (both 0-100 %)
+void power_policy_step(PowerPolicy& policy, bool playing, int fillPercent, int loadPercent);
+
+#endif // POWER_POLICY_H
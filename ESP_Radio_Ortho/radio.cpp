@@ -1,5 +1,8 @@
 #include "radio.h"
 #include "debug_config.h"
+#include "boot_timeline.h"
+#include "dsp.h"
+#include "config.h"
 #include <Arduino.h>
 #include <WiFi.h>
 
@@ -9,34 +12,281 @@
 #define I2S_DMA_BUF_LEN 512
 #include <Audio.h>
 
+#if PIPELINE_BENCHMARK
+#include <LittleFS.h>
+#include <esp_heap_caps.h>
+#include <atomic>
+#endif
+
 // XIAO_ESP32S3 pin definitions: D0=GPIO1, D1=GPIO2, D2=GPIO3
 #define I2S_DOUT  2   // MAX98357 DIN (D1)
 #define I2S_BCLK  3   // MAX98357 BCLK (D2)
 #define I2S_LRC   1   // MAX98357 LRC (D0)
 
 // --- WiFi & Radio Configuration ---
-const char* ssid     = "MokuMoku";
-const char* password = "h1tz31mp4rk1nb3rl1n";
-const char* stream_url = "https://st01.sslstream.dlf.de/dlf/01/128/mp3/stream.mp3?aggregator=web";
+// Credentials and station presets come from the configuration image (config.h).
+static int currentPreset = 0;
+static volatile int32_t presetStepsRequested = 0; // Written by the BLE task only
+static int32_t presetStepsApplied = 0;            // Written by radio_loop() only
+static const char* stream_url = nullptr;  // URL of the current preset, read in place
+static bool radioReady = false;           // WiFi and audio output are up
 
 // --- Audio State ---
 static Audio audio;
-static int currentVolume = 10; // 0-21 for Audio library
+static int currentVolume = 10; // 0-21 for Audio library, default from config
 static bool isPlaying = true;
 
+// --- Decode Load Tracking ---
+// Time spent inside audio.loop() over a one second window, at the current clock.
+static uint32_t loadWindowStartUs = 0;
+static uint32_t loadBusyUs = 0;
+static int decodeLoadPercent = 0;
+static bool firstAudioDecoded = false;
+
+// --- Stream Health ---
+#define STREAM_STALL_MS       3000  // Stream not running this long while playing -> reconnect
+#define STREAM_RETRY_MS       5000  // Minimum gap between reconnect attempts
+#define UNDERRUN_REARM_PERCENT 10   // Buffer must refill this far before the next underrun counts
+static unsigned long streamDownSince = 0;
+static unsigned long lastReconnectTime = 0;
+static uint32_t streamReconnects = 0;
+static uint32_t streamUnderruns = 0;
+static bool underrunArmed = false;
+
+#if PIPELINE_BENCHMARK
+// --- Pipeline Benchmark ---
+// Decodes PIPELINE_BENCHMARK_FILE (or PIPELINE_BENCHMARK_URL) through the same
+// buffer/decode/volume/DSP path as the stream and reports cost per second of
+// audio at end of file (or after PIPELINE_BENCHMARK_SECONDS).
+#ifdef PIPELINE_BENCHMARK_URL
+#define BENCH_NULL_SINK 0  // Network runs are paced by I2S so the buffer drains in real time
+#else
+#define BENCH_NULL_SINK PIPELINE_BENCHMARK_NULL_SINK
+#endif
+#define BENCH_STALL_MS 200  // No output for this long after the first audio = prebuffer stall
+
+static struct {
+  uint64_t framesOut;      // Decoded frames handed to the output stage
+  uint32_t sampleRate;
+  uint32_t startUs;
+  unsigned long startMs;
+  uint64_t busyUs;         // Time spent inside audio.loop()
+  size_t heapAtStart;
+  size_t blocksAtStart;    // Live heap blocks before starting
+  // Prebuffering
+  unsigned long firstAudioMs;    // Time to the first decoded frame, 0 = none yet
+  unsigned long lastOutputMs;
+  uint64_t lastFramesOut;
+  uint32_t stalls;
+  unsigned long stalledMs;
+  uint32_t underrunsAtStart;
+  uint32_t reconnectsAtStart;
+  // Heap change across each audio.loop() call (works without heap hooks)
+  uint32_t loopCalls;
+  uint32_t allocatingCalls;  // Calls that left more live blocks than they found
+  uint32_t blocksAllocated;  // Net blocks added, summed over those calls
+  uint32_t blocksFreed;      // Net blocks released, summed over shrinking calls
+  uint64_t bytesAllocated;
+  size_t blocksBeforeCall;
+  size_t bytesBeforeCall;
+  bool done;
+} bench;
+
+// Gross allocation counts (every malloc, not only the net change per call)
+// need the IDF heap hooks (CONFIG_HEAP_USE_HOOKS), which a stock Arduino core
+// does not enable. They are called for every malloc/free in any task, so they
+// only bump counters.
+#if CONFIG_HEAP_USE_HOOKS
+static volatile bool benchCountAllocs = false;
+static std::atomic<uint32_t> benchAllocs(0);
+static std::atomic<uint32_t> benchFrees(0);
+static std::atomic<uint32_t> benchAllocBytes(0);  // 32-bit so the hooks stay lock-free
+
+extern "C" IRAM_ATTR void esp_heap_trace_alloc_hook(void* ptr, size_t size, uint32_t /*caps*/) {
+  if (!benchCountAllocs || ptr == nullptr) return;
+  benchAllocs.fetch_add(1, std::memory_order_relaxed);
+  benchAllocBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+extern "C" IRAM_ATTR void esp_heap_trace_free_hook(void* ptr) {
+  if (!benchCountAllocs || ptr == nullptr) return;
+  benchFrees.fetch_add(1, std::memory_order_relaxed);
+}
+#endif
+
+static size_t bench_heap_blocks() {
+  multi_heap_info_t info;
+  heap_caps_get_info(&info, MALLOC_CAP_DEFAULT);
+  return info.allocated_blocks;
+}
+
+static void bench_start() {
+  memset(&bench, 0, sizeof(bench));
+  bench.heapAtStart = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+  bench.blocksAtStart = bench_heap_blocks();
+  bench.underrunsAtStart = streamUnderruns;
+  bench.reconnectsAtStart = streamReconnects;
+  bench.startUs = micros();
+  bench.startMs = millis();
+  #if CONFIG_HEAP_USE_HOOKS
+    benchAllocs = 0;
+    benchFrees = 0;
+    benchAllocBytes = 0;
+    benchCountAllocs = true;
+  #endif
+}
+
+// Heap walk before each audio.loop() call, outside the timed section
+static void bench_loop_begin() {
+  if (bench.done) return;
+  multi_heap_info_t info;
+  heap_caps_get_info(&info, MALLOC_CAP_DEFAULT);
+  bench.blocksBeforeCall = info.allocated_blocks;
+  bench.bytesBeforeCall = info.total_allocated_bytes;
+}
+
+static void bench_report();
+
+// After each audio.loop() call: heap change, output gaps and the time limit
+static void bench_loop_end(uint32_t elapsedUs) {
+  if (bench.done) return;
+  bench.busyUs += elapsedUs;
+
+  // Net change only: a malloc freed within the same call is not seen. Other
+  // tasks (the WiFi stack in network runs) are included.
+  multi_heap_info_t info;
+  heap_caps_get_info(&info, MALLOC_CAP_DEFAULT);
+  bench.loopCalls++;
+  if (info.allocated_blocks > bench.blocksBeforeCall) {
+    bench.allocatingCalls++;
+    bench.blocksAllocated += info.allocated_blocks - bench.blocksBeforeCall;
+  } else {
+    bench.blocksFreed += bench.blocksBeforeCall - info.allocated_blocks;
+  }
+  if (info.total_allocated_bytes > bench.bytesBeforeCall) {
+    bench.bytesAllocated += info.total_allocated_bytes - bench.bytesBeforeCall;
+  }
+
+  unsigned long now = millis();
+  if (bench.framesOut != bench.lastFramesOut) {
+    if (bench.firstAudioMs == 0) {
+      bench.firstAudioMs = now - bench.startMs;
+    } else if (now - bench.lastOutputMs > BENCH_STALL_MS) {
+      bench.stalls++;
+      bench.stalledMs += now - bench.lastOutputMs;
+    }
+    bench.lastFramesOut = bench.framesOut;
+    bench.lastOutputMs = now;
+  }
+
+  #ifdef PIPELINE_BENCHMARK_URL
+    if (now - bench.startMs >= (unsigned long)PIPELINE_BENCHMARK_SECONDS * 1000) {
+      bench.done = true;
+      bench_report();
+      isPlaying = false;  // Not a dropout: keep the watchdog from reconnecting
+      audio.stopSong();
+    }
+  #endif
+}
+
+static void bench_report() {
+  double audioSec = bench.sampleRate ? (double)bench.framesOut / bench.sampleRate : 0.0;
+  double busySec = bench.busyUs / 1e6;
+  double wallSec = (micros() - bench.startUs) / 1e6;
+  Serial.println("\n========================================");
+  Serial.println("*** PIPELINE BENCHMARK RESULT ***");
+  #ifdef PIPELINE_BENCHMARK_URL
+    Serial.printf(">>> Stream: %s (I2S sink)\n", PIPELINE_BENCHMARK_URL);
+  #else
+    Serial.printf(">>> File: %s (%s sink)\n", PIPELINE_BENCHMARK_FILE, BENCH_NULL_SINK ? "null" : "I2S");
+  #endif
+  Serial.printf(">>> Audio decoded: %.2f s at %lu Hz, CPU %lu MHz\n",
+                audioSec, (unsigned long)bench.sampleRate, (unsigned long)getCpuFrequencyMhz());
+  Serial.printf(">>> Wall time: %.2f s, busy in audio.loop(): %.2f s\n", wallSec, busySec);
+  if (audioSec > 0 && busySec > 0) {
+    Serial.printf(">>> Real-time factor: %.1fx\n", audioSec / busySec);
+    Serial.printf(">>> CPU per second of audio: %.1f ms\n", busySec * 1000.0 / audioSec);
+  }
+  Serial.printf(">>> Time to first audio: %lu ms\n", bench.firstAudioMs);
+  Serial.printf(">>> Prebuffer stalls: %lu (%lu ms without output)",
+                (unsigned long)bench.stalls, bench.stalledMs);
+  #ifdef PIPELINE_BENCHMARK_URL
+    Serial.printf(", underruns: %lu, reconnects: %lu",
+                  (unsigned long)(streamUnderruns - bench.underrunsAtStart),
+                  (unsigned long)(streamReconnects - bench.reconnectsAtStart));
+  #endif
+  Serial.println();
+  // The heap low-water mark catches transients between loop() calls. It is
+  // since boot, but BLE and WiFi are not started in benchmark mode, so the
+  // run itself sets it.
+  size_t heapMin = heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT);
+  Serial.printf(">>> Peak heap used: %lu bytes\n",
+                (unsigned long)(bench.heapAtStart > heapMin ? bench.heapAtStart - heapMin : 0));
+  Serial.printf(">>> Heap change per audio.loop(): %lu of %lu calls allocated, +%lu blocks "
+                "(%.1f per second of audio) / +%llu bytes net, -%lu blocks freed\n",
+                (unsigned long)bench.allocatingCalls, (unsigned long)bench.loopCalls,
+                (unsigned long)bench.blocksAllocated, audioSec > 0 ? bench.blocksAllocated / audioSec : 0.0,
+                (unsigned long long)bench.bytesAllocated, (unsigned long)bench.blocksFreed);
+  #if CONFIG_HEAP_USE_HOOKS
+    benchCountAllocs = false;
+    Serial.printf(">>> Allocations (heap hooks): %lu (%lu bytes), frees: %lu, %.1f allocations per second of audio\n",
+                  (unsigned long)benchAllocs.load(), (unsigned long)benchAllocBytes.load(),
+                  (unsigned long)benchFrees.load(), audioSec > 0 ? benchAllocs.load() / audioSec : 0.0);
+  #endif
+  Serial.printf(">>> Live heap blocks: start %u, end %u\n",
+                (unsigned)bench.blocksAtStart, (unsigned)bench_heap_blocks());
+  Serial.println("========================================\n");
+}
+
+void audio_eof_mp3(const char *info) {
+  if (bench.done) return;
+  bench.done = true;
+  bench_report();
+}
+#endif
+
 // --- Audio library callbacks ---
 void audio_info(const char *info){
   Serial.print("info        ");
   Serial.println(info);
 }
 
+// Post-decode hook: runs the EQ/limiter chain on each block before it goes to I2S.
+// The library always hands us interleaved stereo frames (mono is duplicated),
+// so `channels` only describes the source. Coefficients are recomputed
+// whenever the stream's sample rate changes.
+void audio_process_i2s(int16_t* outBuff, uint16_t validSamples, uint8_t bitsPerSample, uint8_t channels, bool *continueI2S) {
+  static uint32_t dspRate = 0;
+  *continueI2S = true;
+  #if PIPELINE_BENCHMARK
+    bench.framesOut += validSamples;
+    bench.sampleRate = audio.getSampleRate();
+    *continueI2S = !BENCH_NULL_SINK;
+  #endif
+  if (bitsPerSample != 16) return;
+  uint32_t rate = audio.getSampleRate();
+  if (rate != dspRate) {
+    dsp_setup(rate);
+    dspRate = rate;
+  }
+  dsp_process(outBuff, validSamples, 2);
+}
+
 // --- Public Functions ---
 
-void radio_setup() {
-  // Initialize WiFi
+static const char* preset_url(int preset) {
+#ifdef STREAM_URL_OVERRIDE
+  (void)preset;
+  return STREAM_URL_OVERRIDE;
+#else
+  return config_get()->presets[preset].url;
+#endif
+}
+
+static void wifi_connect() {
   WiFi.mode(WIFI_STA);
-  WiFi.setSleep(true);
-  WiFi.begin(ssid, password);
+  WiFi.setSleep(WIFI_PS_MIN_MODEM); // The power governor adjusts this once playing
+  WiFi.begin(config_get()->ssid, config_get()->password);
 
   Serial.print("Connecting to WiFi");
   while (WiFi.status() != WL_CONNECTED) {
@@ -44,8 +294,41 @@ void radio_setup() {
     delay(300);
   }
   Serial.println("\nWiFi connected");
+  boot_timeline_mark(BOOT_MARK_WIFI);
   Serial.print("IP: ");
   Serial.println(WiFi.localIP());
+}
+
+void radio_setup() {
+#if PIPELINE_BENCHMARK
+  #ifdef PIPELINE_BENCHMARK_URL
+    // Network run: the server's script supplies the jitter
+    wifi_connect();
+  #else
+    // Offline run: no WiFi, decode a local file as fast as the pipeline allows
+    if (!LittleFS.begin()) {
+      Serial.println(">>> ERROR: Failed to mount LittleFS for the pipeline benchmark.");
+      return;
+    }
+  #endif
+  audio.setPinout(I2S_BCLK, I2S_LRC, I2S_DOUT);
+  audio.setVolume(currentVolume);
+  Serial.print(">>> Pipeline benchmark: decoding ");
+  #ifdef PIPELINE_BENCHMARK_URL
+    Serial.println(PIPELINE_BENCHMARK_URL);
+    stream_url = PIPELINE_BENCHMARK_URL;  // The watchdog reconnects here
+    radioReady = true;
+    bench_start();
+    audio.connecttohost(stream_url);
+  #else
+    Serial.println(PIPELINE_BENCHMARK_FILE);
+    bench_start();
+    audio.connecttoFS(LittleFS, PIPELINE_BENCHMARK_FILE);
+  #endif
+  return;
+#endif
+
+  wifi_connect();
 
   // Initialize Audio
   audio.setPinout(I2S_BCLK, I2S_LRC, I2S_DOUT);
@@ -55,14 +338,100 @@ void radio_setup() {
   Serial.println("/21");
 
   // Start radio stream
+  radioReady = true;
+  Serial.print("Preset: ");
+  Serial.println(config_get()->presets[currentPreset].name);
   if (isPlaying) {
     audio.connecttohost(stream_url);
   }
 }
 
+// Count buffer underruns and reconnect when the stream has dropped
+static void stream_watchdog() {
+  unsigned long now = millis();
+
+  if (audio.isRunning()) {
+    streamDownSince = 0;
+    int fill = radio_get_buffer_fill();
+    if (fill == 0 && underrunArmed) {
+      streamUnderruns++;
+      underrunArmed = false;
+      Serial.print("*** Stream UNDERRUN #");
+      Serial.println(streamUnderruns);
+    } else if (fill >= UNDERRUN_REARM_PERCENT) {
+      underrunArmed = true;
+    }
+    return;
+  }
+
+  underrunArmed = false;
+  if (streamDownSince == 0) {
+    streamDownSince = now;
+    return;
+  }
+  if (now - streamDownSince > STREAM_STALL_MS && now - lastReconnectTime > STREAM_RETRY_MS) {
+    streamReconnects++;
+    lastReconnectTime = now;
+    Serial.print("*** Stream stopped. Reconnecting (#");
+    Serial.print(streamReconnects);
+    Serial.println(")...");
+    audio.connecttohost(stream_url);
+  }
+}
+
+// Switch presets on the loop task: connecttohost() blocks and must not race
+// audio.loop(), so button presses only count steps
+static void apply_preset_steps() {
+  int32_t steps = presetStepsRequested - presetStepsApplied;
+  if (steps == 0) return;
+  presetStepsApplied += steps;
+  int count = config_get()->presetCount;
+  int preset = (currentPreset + steps) % count;
+  currentPreset = preset < 0 ? preset + count : preset; // Wrap around in both directions
+  stream_url = preset_url(currentPreset);
+  Serial.print("*** Preset ");
+  Serial.print(currentPreset);
+  Serial.print(": ");
+  Serial.println(config_get()->presets[currentPreset].name);
+  if (radioReady && isPlaying) {
+    streamDownSince = 0;
+    audio.connecttohost(stream_url);
+  }
+}
+
 void radio_loop() {
+  apply_preset_steps();
+
   if (isPlaying) {
+    #if PIPELINE_BENCHMARK
+      bench_loop_begin();
+    #endif
+    uint32_t start = micros();
     audio.loop();
+    uint32_t elapsed = micros() - start;
+    loadBusyUs += elapsed;
+    #if PIPELINE_BENCHMARK
+      bench_loop_end(elapsed);
+    #endif
+
+    // The bitrate is known once the decoder has parsed the first frame
+    if (!firstAudioDecoded && audio.getBitRate() > 0) {
+      firstAudioDecoded = true;
+      boot_timeline_mark(BOOT_MARK_FIRST_AUDIO);
+    }
+
+    #if !PIPELINE_BENCHMARK || defined(PIPELINE_BENCHMARK_URL)
+      stream_watchdog();
+    #endif
+  }
+
+  uint32_t now = micros();
+  uint32_t window = now - loadWindowStartUs;
+  if (window >= 1000000) {
+    uint32_t load = loadBusyUs / (window / 100);
+    decodeLoadPercent = load > 100 ? 100 : (int)load;
+    loadBusyUs = 0;
+    loadWindowStartUs = now;
   }
 }
 
@@ -100,6 +469,7 @@ void radio_toggle_play_pause() {
   isPlaying = !isPlaying;
   if (isPlaying) {
     Serial.println("*** Radio PLAY ***");
+    streamDownSince = 0;
     audio.connecttohost(stream_url);
   } else {
     Serial.println("*** Radio PAUSE ***");
@@ -114,3 +484,58 @@ bool radio_is_playing() {
 int radio_get_volume() {
     return currentVolume;
 }
+
+void radio_apply_config() {
+    const RadioConfig* cfg = config_get();
+    currentVolume = constrain(cfg->defaultVolume, 0, 21);
+    currentPreset = cfg->defaultPreset;
+    stream_url = preset_url(currentPreset);
+}
+
+void radio_restore_state(int volume, bool playing, int preset) {
+    currentVolume = constrain(volume, 0, 21);
+    isPlaying = playing;
+    currentPreset = constrain(preset, 0, config_get()->presetCount - 1);
+    stream_url = preset_url(currentPreset);
+    Serial.print("*** Restored radio state: volume ");
+    Serial.print(currentVolume);
+    Serial.print("/21, preset ");
+    Serial.print(currentPreset);
+    Serial.print(", ");
+    Serial.println(isPlaying ? "playing" : "paused");
+}
+
+void radio_step_preset(int step) {
+    presetStepsRequested = presetStepsRequested + step;
+}
+
+int radio_get_preset() {
+    return currentPreset;
+}
+
+int radio_get_buffer_fill() {
+    uint32_t filled = audio.inBufferFilled();
+    uint32_t total = filled + audio.inBufferFree();
+    if (total == 0) return 0;
+    return (int)((uint64_t)filled * 100 / total);
+}
+
+uint32_t radio_get_buffer_bytes() {
+    return audio.inBufferFilled();
+}
+
+uint32_t radio_get_bitrate() {
+    return audio.getBitRate();
+}
+
+int radio_get_decode_load() {
+    return decodeLoadPercent;
+}
+
+uint32_t radio_get_underruns() {
+    return streamUnderruns;
+}
+
+uint32_t radio_get_reconnects() {
+    return streamReconnects;
+}
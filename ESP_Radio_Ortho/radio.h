@@ -1,6 +1,8 @@
 #ifndef RADIO_H
 #define RADIO_H
 
+#include <stdint.h>
+
 // Setup Wi-Fi, audio, and start the radio stream
 void radio_setup();
 
@@ -15,4 +17,25 @@ void radio_toggle_play_pause();
 bool radio_is_playing();
 int radio_get_volume();
 
+// Load default volume and preset from the configuration image
+void radio_apply_config();
+
+// Restore cached state before radio_setup() (e.g. after waking from deep sleep)
+void radio_restore_state(int volume, bool playing, int preset);
+
+// Station presets from the configuration image (wraps around). Safe to call
+// from the BLE task: the switch itself happens in radio_loop().
+void radio_step_preset(int step);
+int radio_get_preset();
+
+// Stream health for the power governor
+int radio_get_buffer_fill();   // Input buffer fill, 0-100 %
+int radio_get_decode_load();   // Share of wall time spent in audio.loop(), 0-100 %
+uint32_t radio_get_buffer_bytes(); // Bytes waiting in the input buffer
+uint32_t radio_get_bitrate();      // Stream bitrate in bit/s, 0 until the first frame
+
+// Stream health counters since boot
+uint32_t radio_get_underruns();
+uint32_t radio_get_reconnects();
+
 #endif // RADIO_H
@@ -0,0 +1,59 @@
+#include "rumble_queue.h"
+#include <string.h>
+
+void rumble_queue_reset(RumbleQueue& queue) {
+  memset(queue.slots, 0, sizeof(queue.slots));
+  memset(&queue.stats, 0, sizeof(queue.stats));
+  queue.head.store(0);
+  queue.tail.store(0);
+  queue.busyUntilUs = 0;
+}
+
+bool rumble_queue_push(RumbleQueue& queue, uint8_t strength, uint8_t duration, int64_t pressedUs) {
+  uint32_t head = queue.head.load(std::memory_order_relaxed);
+  uint32_t tail = queue.tail.load(std::memory_order_acquire);
+  if (head - tail >= RUMBLE_QUEUE_LENGTH) {
+    queue.stats.dropped++;
+    return false;
+  }
+  RumblePulse& slot = queue.slots[head % RUMBLE_QUEUE_LENGTH];
+  slot.strength = strength;
+  slot.duration = duration;
+  slot.pressedUs = pressedUs;
+  queue.head.store(head + 1, std::memory_order_release);
+  queue.stats.queued++;
+  return true;
+}
+
+bool rumble_queue_service(RumbleQueue& queue, RumbleDriver& driver) {
+  uint32_t tail = queue.tail.load(std::memory_order_relaxed);
+  uint32_t head = queue.head.load(std::memory_order_acquire);
+  if (!driver.canWrite()) {
+    queue.tail.store(head, std::memory_order_release);
+    return false;
+  }
+  if (head == tail) return false;
+  if (driver.nowUs() < queue.busyUntilUs) return false;
+
+  RumblePulse merged = queue.slots[tail % RUMBLE_QUEUE_LENGTH];
+  for (uint32_t i = tail + 1; i != head; i++) {
+    const RumblePulse& next = queue.slots[i % RUMBLE_QUEUE_LENGTH];
+    if (next.strength > merged.strength) merged.strength = next.strength;
+    if (next.duration > merged.duration) merged.duration = next.duration;
+    if (next.pressedUs < merged.pressedUs) merged.pressedUs = next.pressedUs;
+    queue.stats.coalesced++;
+  }
+  queue.tail.store(head, std::memory_order_release);
+
+  driver.write(merged);
+  int64_t now = driver.nowUs();
+  queue.busyUntilUs = now + (int64_t)merged.duration * 10000;
+
+  RumbleStats& s = queue.stats;
+  int64_t latency = now - merged.pressedUs;
+  if (s.sent == 0 || latency < s.latencyMinUs) s.latencyMinUs = latency;
+  if (latency > s.latencyMaxUs) s.latencyMaxUs = latency;
+  s.latencyTotalUs += latency;
+  s.sent++;
+  return true;
+}
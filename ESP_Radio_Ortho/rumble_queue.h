@@ -0,0 +1,62 @@
+#ifndef RUMBLE_QUEUE_H
+#define RUMBLE_QUEUE_H
+
+#include <stdint.h>
+#include <atomic>
+
+// Rumble feedback queue between the BLE notify callback (producer) and the
+// main loop (consumer). Pushing never waits: when the queue is full the pulse
+// is dropped, so input handling never stalls. Pulses that pile up while one
+// is still playing are merged into one. It has no Arduino or BLE library
+// dependencies: ble_control.cpp drives it with the real output report,
+// host/rumble_test.cpp with a recording driver.
+
+#define RUMBLE_QUEUE_LENGTH 4   // Power of two
+
+struct RumblePulse {
+  uint8_t strength;     // Motor strength 0-100
+  uint8_t duration;     // Units of 10 ms
+  int64_t pressedUs;    // When the input that caused it arrived
+};
+
+struct RumbleStats {
+  uint32_t queued;       // Written by the producer
+  uint32_t dropped;      // Queue full; written by the producer
+  uint32_t coalesced;    // Merged into another pulse
+  uint32_t sent;
+  int64_t latencyMinUs;  // Input arrival to report write
+  int64_t latencyMaxUs;
+  int64_t latencyTotalUs;
+};
+
+// What the queue needs from the clock and the output report
+class RumbleDriver {
+ public:
+  virtual ~RumbleDriver() {}
+  virtual int64_t nowUs() = 0;
+  virtual bool canWrite() = 0;   // Output report known and link up
+  virtual void write(const RumblePulse& pulse) = 0;
+};
+
+// Single producer, single consumer ring. head is only written by the
+// producer, tail only by the consumer.
+struct RumbleQueue {
+  RumblePulse slots[RUMBLE_QUEUE_LENGTH];
+  std::atomic<uint32_t> head;
+  std::atomic<uint32_t> tail;
+  int64_t busyUntilUs;           // Previous pulse still playing
+  RumbleStats stats;
+};
+
+void rumble_queue_reset(RumbleQueue& queue);
+
+// Producer side; never blocks. False if the pulse was dropped.
+bool rumble_queue_push(RumbleQueue& queue, uint8_t strength, uint8_t duration, int64_t pressedUs);
+
+// Consumer side, one write per pulse window: merges everything queued into
+// one pulse and writes it. Latency is measured from the earliest pressedUs.
+// Empties the queue without writing while the driver cannot write. True if a
+// pulse was written.
+bool rumble_queue_service(RumbleQueue& queue, RumbleDriver& driver);
+
+#endif // RUMBLE_QUEUE_H
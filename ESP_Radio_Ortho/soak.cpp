@@ -0,0 +1,49 @@
+#include "soak.h"
+#include "radio.h"
+#include "debug_config.h"
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+
+#if SOAK_TELEMETRY
+
+static unsigned long lastReportTime = 0;
+static bool haveBaseline = false;
+static uint32_t baselineFreeHeap = 0;
+static uint32_t baselineLargestBlock = 0;
+
+void soak_loop() {
+  unsigned long now = millis();
+  if (haveBaseline && now - lastReportTime < SOAK_REPORT_INTERVAL_MS) return;
+  lastReportTime = now;
+
+  uint32_t freeHeap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  uint32_t minFreeHeap = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+  uint32_t largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+  // 0% = all free memory in one block, rising as the heap fragments
+  uint32_t fragPercent = freeHeap ? 100 - (uint32_t)((uint64_t)largestBlock * 100 / freeHeap) : 0;
+
+  if (!haveBaseline) {
+    baselineFreeHeap = freeHeap;
+    baselineLargestBlock = largestBlock;
+    haveBaseline = true;
+  }
+
+  // One line per sample so a log can be plotted directly
+  Serial.printf("SOAK t=%lu underruns=%lu reconnects=%lu heap=%lu heap_min=%lu "
+                "largest=%lu frag=%lu%% heap_drift=%ld largest_drift=%ld\n",
+                now / 1000,
+                (unsigned long)radio_get_underruns(),
+                (unsigned long)radio_get_reconnects(),
+                (unsigned long)freeHeap,
+                (unsigned long)minFreeHeap,
+                (unsigned long)largestBlock,
+                (unsigned long)fragPercent,
+                (long)freeHeap - (long)baselineFreeHeap,
+                (long)largestBlock - (long)baselineLargestBlock);
+}
+
+#else
+
+void soak_loop() {}
+
+#endif // SOAK_TELEMETRY
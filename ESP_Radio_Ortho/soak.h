@@ -0,0 +1,8 @@
+#ifndef SOAK_H
+#define SOAK_H
+
+// Periodic long-run telemetry: stream underruns and reconnects, heap
+// low-water mark and fragmentation, with drift since the first sample.
+void soak_loop();
+
+#endif // SOAK_H
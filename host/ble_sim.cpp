@@ -0,0 +1,347 @@
+// Deterministic virtual-clock simulator for the controller link state machine
+// (ESP_Radio_Ortho/ble_link.cpp). A scripted controller advertises, pairs,
+// drops out, powers off and misbehaves; the state machine runs unchanged on
+// top, as in the sketch's loop(). Reports distributions of time-to-reconnect,
+// time blocked in delay() and main-loop stalls, and flags stuck states.
+//
+// Usage: ble_sim [--runs N] [--hours H] [--seed S] [--verbose]
+// Exits non-zero if, in any run, the controller was available without a
+// session and no connect attempt was made for STUCK_FLAG_MS. Scenarios with
+// silent drop-outs are also run with stuck-link recovery off, to show what
+// report-only detection would leave behind (not counted in the exit status).
+
+#include "ble_link.h"
+#include "debug_config.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#define LOOP_DELAY_MS       10       // delay(10) at the end of loop()
+#define SCAN_CONNECT_TIMEOUT_MS 30000  // Stack default when the scanned device vanishes
+#define STUCK_FLAG_MS       60000    // Controller available, no session and no attempt this long
+#define NEVER               ~0UL
+
+struct Scenario {
+  const char* name;
+  double advertMeanMs;       // Mean time for a running scan to see the controller
+  double sessionMeanMs;      // Mean session length before a drop-out (0 = never)
+  double pairingFailRate;    // Link drops during the pairing wait
+  double missingServiceRate; // Discovery finds no usable service
+  double silentDropRate;     // Drop-outs that never deliver a disconnect callback
+  double onMeanMs;           // Mean time between power-offs (0 = always on)
+  double offMeanMs;          // Mean power-off duration
+  bool fastResume;           // Start with a cached address, as after deep sleep
+};
+
+static const Scenario scenarios[] = {
+  {"steady",            300, 300000, 0.0,  0.0,  0.0, 0,      0,     false},
+  {"flaky pairing",     300, 120000, 0.4,  0.0,  0.0, 0,      0,     false},
+  {"missing service",   300, 120000, 0.0,  0.3,  0.0, 0,      0,     false},
+  {"link desync",       300,  60000, 0.0,  0.0,  0.5, 0,      0,     false},
+  {"power cycling",     800, 0,      0.1,  0.05, 0.1, 240000, 60000, false},
+  {"fast resume",       300, 300000, 0.1,  0.0,  0.0, 120000, 60000, true},
+  {"hostile",          2000,  30000, 0.3,  0.2,  0.3, 180000, 30000, false},
+};
+
+struct RunResult {
+  std::vector<double> reconnectMs;     // Controller available -> session up
+  std::vector<double> blockedPerReconnectMs;
+  double blockedMs;
+  double maxLoopStallMs;
+  uint32_t sessions;
+  uint32_t stuckLink;
+  uint32_t stuckScan;
+  uint32_t stuckFlags;                 // Independent check against the scripted truth
+};
+
+class SimDriver : public BleLinkDriver {
+ public:
+  SimDriver(const Scenario& scenario, uint32_t seed, bool verbose)
+      : sc(scenario), rng(seed), verbose(verbose) {}
+
+  BleLink link;
+  RunResult result;
+
+  void run(unsigned long durationMs, bool recoverStuckLink) {
+    memset((void*)&result, 0, sizeof(result));
+    ble_link_reset(link, 0);
+    link.recoverStuckLink = recoverStuckLink;
+    powerOn = true;
+    powerToggleAt = sc.onMeanMs > 0 ? (unsigned long)expo(sc.onMeanMs) : NEVER;
+    if (sc.fastResume) {
+      // Resumed from deep sleep: the controller may have been switched off meanwhile
+      if (uniform() < 0.5) {
+        powerOn = false;
+        availableSince = NEVER;
+        powerToggleAt = (unsigned long)expo(sc.offMeanMs > 0 ? sc.offMeanMs : 60000);
+      }
+      ble_link_target_found(link, true);
+    } else {
+      startScan();
+    }
+
+    while (clock < durationMs) {
+      unsigned long before = clock;
+      ble_link_loop(link, *this);
+      double stall = clock - before;
+      if (stall > result.maxLoopStallMs) result.maxLoopStallMs = stall;
+      advance(LOOP_DELAY_MS);
+      check_stuck();
+    }
+    result.blockedMs = link.stats.blockedMs;
+    result.stuckLink = link.stats.stuckLink;
+    result.stuckScan = link.stats.stuckScan;
+  }
+
+  // --- BleLinkDriver ---
+  unsigned long now() override { return clock; }
+  void sleep(unsigned long ms) override { advance(ms); }
+  bool isScanning() override { return scanning; }
+
+  void startScan() override {
+    scanning = true;
+    schedule_find();
+  }
+
+  bool openLink(bool fastResume) override {
+    lastAttemptAt = clock;
+    if (!powerOn) {
+      advance(fastResume ? FAST_CONNECT_TIMEOUT_MS : SCAN_CONNECT_TIMEOUT_MS);
+      return false;
+    }
+    advance(50 + rng() % 350);
+    if (!powerOn) return false;
+    linkUp = true;
+    ble_link_connected(link);  // onConnect
+    if (uniform() < sc.pairingFailRate) {
+      schedule_drop(clock + 300 + rng() % (PAIRING_WAIT_MS - 300), false);
+    }
+    return true;
+  }
+
+  bool isLinkUp() override { return linkUp; }
+
+  bool discover() override {
+    advance(200 + rng() % 600);
+    if (!linkUp) return false;
+    if (uniform() < sc.missingServiceRate) {
+      drop_link(false);  // pClient->disconnect()
+      return false;
+    }
+    session = true;
+    result.sessions++;
+    if (availableSince != NEVER) {
+      result.reconnectMs.push_back(clock - availableSince);
+      result.blockedPerReconnectMs.push_back(link.stats.blockedMs - blockedAtOutage);
+    }
+    availableSince = NEVER;
+    stuckFlagged = false;
+    if (sc.sessionMeanMs > 0) {
+      schedule_drop(clock + (unsigned long)expo(sc.sessionMeanMs), uniform() < sc.silentDropRate);
+    }
+    return true;
+  }
+
+  void attemptFinished(bool, bool) override {}
+
+  void log(const char* message) override {
+    if (verbose) printf("[%10lu] %s\n", clock, message);
+  }
+
+ private:
+  const Scenario& sc;
+  std::mt19937 rng;
+  bool verbose;
+
+  unsigned long clock = 0;
+  bool powerOn = true;
+  unsigned long powerToggleAt = NEVER;
+  bool scanning = false;
+  unsigned long findAt = NEVER;
+  bool linkUp = false;
+  bool session = false;
+  unsigned long dropAt = NEVER;
+  bool dropSilent = false;
+
+  // Scripted truth: when the controller last became usable without a session
+  unsigned long availableSince = 0;
+  unsigned long blockedAtOutage = 0;
+  unsigned long lastAttemptAt = 0;
+  bool stuckFlagged = false;
+
+  double uniform() { return std::uniform_real_distribution<double>(0.0, 1.0)(rng); }
+  double expo(double mean) { return std::exponential_distribution<double>(1.0 / mean)(rng); }
+
+  void schedule_find() {
+    findAt = (scanning && powerOn) ? clock + 1 + (unsigned long)expo(sc.advertMeanMs) : NEVER;
+  }
+
+  void schedule_drop(unsigned long at, bool silent) {
+    dropAt = at;
+    dropSilent = silent;
+  }
+
+  void drop_link(bool silent) {
+    dropAt = NEVER;
+    if (!linkUp) return;
+    linkUp = false;
+    if (session) {
+      session = false;
+      mark_outage();
+    }
+    if (!silent) ble_link_disconnected(link, clock);  // onDisconnect
+  }
+
+  void mark_outage() {
+    if (powerOn && availableSince == NEVER) {
+      availableSince = clock;
+      blockedAtOutage = link.stats.blockedMs;
+    }
+  }
+
+  // Run scripted events up to the target time; callbacks fire as they would
+  // from the BLE task, including while the loop is blocked
+  void advance(unsigned long ms) {
+    unsigned long target = clock + ms;
+    for (;;) {
+      unsigned long next = std::min(std::min(powerToggleAt, findAt), dropAt);
+      if (next > target) break;
+      clock = next;
+      if (next == dropAt) {
+        drop_link(dropSilent);
+      } else if (next == powerToggleAt) {
+        toggle_power();
+      } else {
+        findAt = NEVER;
+        if (scanning && powerOn) {
+          scanning = false;  // The scan callback stops the scan
+          ble_link_target_found(link, false);
+        }
+      }
+    }
+    clock = target;
+  }
+
+  void toggle_power() {
+    powerOn = !powerOn;
+    if (powerOn) {
+      powerToggleAt = clock + (unsigned long)expo(sc.onMeanMs);
+      if (!session) {
+        availableSince = clock;
+        blockedAtOutage = link.stats.blockedMs;
+        stuckFlagged = false;
+      }
+      schedule_find();
+    } else {
+      powerToggleAt = clock + (unsigned long)expo(sc.offMeanMs);
+      findAt = NEVER;
+      availableSince = NEVER;
+      drop_link(false);  // Supervision timeout
+    }
+  }
+
+  void check_stuck() {
+    if (session || availableSince == NEVER || stuckFlagged) return;
+    unsigned long idleSince = std::max(availableSince, lastAttemptAt);
+    if (clock - idleSince > STUCK_FLAG_MS) {
+      stuckFlagged = true;
+      result.stuckFlags++;
+      if (verbose) printf("[%10lu] SIM: stuck, controller available but no connect attempt\n", clock);
+    }
+  }
+};
+
+static double percentile(std::vector<double>& v, double p) {
+  if (v.empty()) return 0;
+  size_t i = (size_t)std::min<double>(v.size() - 1, floor(p / 100.0 * v.size()));
+  std::nth_element(v.begin(), v.begin() + i, v.end());
+  return v[i];
+}
+
+static void print_distribution(const char* label, std::vector<double>& v) {
+  if (v.empty()) {
+    printf("   %-22s (no samples)\n", label);
+    return;
+  }
+  double maxV = *std::max_element(v.begin(), v.end());
+  double p50 = percentile(v, 50), p90 = percentile(v, 90), p99 = percentile(v, 99);
+  printf("   %-22s n=%-6zu p50=%7.0f p90=%7.0f p99=%7.0f max=%7.0f ms\n", label, v.size(), p50, p90, p99, maxV);
+}
+
+int main(int argc, char** argv) {
+  int runs = 50;
+  double hours = 1.0;
+  uint32_t seed = 1;
+  bool verbose = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) runs = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--hours") == 0 && i + 1 < argc) hours = atof(argv[++i]);
+    else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = (uint32_t)atoi(argv[++i]);
+    else if (strcmp(argv[i], "--verbose") == 0) verbose = true;
+    else {
+      fprintf(stderr, "usage: %s [--runs N] [--hours H] [--seed S] [--verbose]\n", argv[0]);
+      return 2;
+    }
+  }
+  unsigned long durationMs = (unsigned long)(hours * 3600000.0);
+
+  printf("%d runs x %.2f h per scenario, seed %u\n\n", runs, hours, seed);
+  auto wallStart = std::chrono::steady_clock::now();
+  double virtualMs = 0;
+  uint32_t totalStuckFlags = 0;
+
+  for (const Scenario& sc : scenarios) {
+    std::vector<double> reconnect, blockedPerReconnect, blockedPerHour, stalls;
+    uint32_t sessions = 0, stuckLink = 0, stuckScan = 0, stuckFlags = 0, runsWithFlags = 0;
+
+    for (int r = 0; r < runs; r++) {
+      SimDriver sim(sc, seed * 7919u + r, verbose);
+      sim.run(durationMs, true);
+      virtualMs += durationMs;
+      RunResult& res = sim.result;
+      reconnect.insert(reconnect.end(), res.reconnectMs.begin(), res.reconnectMs.end());
+      blockedPerReconnect.insert(blockedPerReconnect.end(), res.blockedPerReconnectMs.begin(),
+                                 res.blockedPerReconnectMs.end());
+      blockedPerHour.push_back(res.blockedMs / hours);
+      stalls.push_back(res.maxLoopStallMs);
+      sessions += res.sessions;
+      stuckLink += res.stuckLink;
+      stuckScan += res.stuckScan;
+      stuckFlags += res.stuckFlags;
+      if (res.stuckFlags > 0) runsWithFlags++;
+    }
+    totalStuckFlags += stuckFlags;
+
+    printf("== %s\n", sc.name);
+    print_distribution("time to reconnect", reconnect);
+    print_distribution("delay() per reconnect", blockedPerReconnect);
+    print_distribution("delay() per hour", blockedPerHour);
+    print_distribution("longest loop() stall", stalls);
+    printf("   sessions=%u stuck detected (link/scan)=%u/%u\n", sessions, stuckLink, stuckScan);
+    printf("   %s: %u flag(s) in %u run(s), controller available >%d s without an attempt\n",
+           stuckFlags ? "STUCK" : "no stuck states", stuckFlags, runsWithFlags, STUCK_FLAG_MS / 1000);
+
+    if (sc.silentDropRate > 0) {
+      uint32_t reportOnlyRuns = 0;
+      for (int r = 0; r < runs; r++) {
+        SimDriver sim(sc, seed * 7919u + r, false);
+        sim.run(durationMs, false);
+        virtualMs += durationMs;
+        if (sim.result.stuckFlags > 0) reportOnlyRuns++;
+      }
+      printf("   with stuck-link recovery off: STUCK in %u of %d run(s)\n", reportOnlyRuns, runs);
+    }
+    printf("\n");
+  }
+
+  double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wallStart).count();
+  printf("simulated %.0f h in %.2f s (%.0fx real time)\n", virtualMs / 3600000.0, wallMs / 1000.0,
+         wallMs > 0 ? virtualMs / wallMs : 0.0);
+  return totalStuckFlags > 0 ? 1 : 0;
+}
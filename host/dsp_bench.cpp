@@ -0,0 +1,62 @@
+// Host benchmark for ESP_Radio_Ortho/dsp.cpp: cycles and nanoseconds per
+// stereo frame at typical Audio library block sizes. Host numbers are for
+// comparing changes to the DSP code; on the device, VERBOSE_DSP_DEBUG
+// reports cycles per frame on the S3 itself.
+
+#include "dsp.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+static uint64_t cycles() { return __rdtsc(); }
+#else
+#define HAVE_TSC 0
+static uint64_t cycles() { return 0; }
+#endif
+
+int main() {
+  const uint32_t fs = 44100;
+  const uint32_t seconds = 20;
+  const uint32_t blockSizes[] = {64, 576, 1152};
+
+  std::vector<int16_t> source(fs * 2);
+  for (uint32_t i = 0; i < fs; i++) {
+    double t = (double)i / fs;
+    int16_t v = (int16_t)lround(20000 * sin(2 * M_PI * 440 * t) + 8000 * sin(2 * M_PI * 5000 * t));
+    source[i * 2] = v;
+    source[i * 2 + 1] = (int16_t)(-v);
+  }
+
+#if DSP_USE_ESP_DSP
+  printf("EQ kernel: esp-dsp (host C port; the S3 runs the aes3 kernel)\n");
+#else
+  printf("EQ kernel: fixed point\n");
+#endif
+  printf("block  frames      ns/frame  %s  realtime x\n", HAVE_TSC ? "TSC cycles/frame" : "");
+  for (uint32_t block : blockSizes) {
+    dsp_setup(fs);
+    std::vector<int16_t> pcm(source);
+    uint64_t frames = 0;
+    uint64_t startCycles = cycles();
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t s = 0; s < seconds; s++) {
+      pcm = source;
+      for (uint32_t offset = 0; offset + block <= fs; offset += block) {
+        dsp_process(&pcm[offset * 2], block, 2);
+        frames += block;
+      }
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    uint64_t spent = cycles() - startCycles;
+
+    printf("%5u  %8llu  %10.2f", block, (unsigned long long)frames, ns / frames);
+    if (HAVE_TSC) printf("  %16.1f", (double)spent / frames);
+    printf("  %10.0f\n", (frames / (double)fs) / (ns / 1e9));
+  }
+  return 0;
+}
@@ -0,0 +1,228 @@
+// Checks ESP_Radio_Ortho/dsp.cpp against a double-precision RBJ biquad
+// cascade, and checks that the limiter never exceeds its threshold and never
+// steps its gain faster than its lookahead ramp allows. Exits non-zero on
+// failure.
+
+#include "dsp.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Must match eqBands and the limiter settings in dsp.cpp
+enum RefType { REF_HIGH_PASS, REF_LOW_SHELF, REF_PEAKING, REF_HIGH_SHELF };
+struct RefBand {
+  RefType type;
+  double freqHz, gainDb, q;
+};
+static const RefBand refBands[] = {
+  {REF_HIGH_PASS,   90.0,  0.0, 0.707},
+  {REF_LOW_SHELF,  250.0, -5.0, 0.707},
+  {REF_PEAKING,   3000.0,  2.0, 1.0},
+  {REF_HIGH_SHELF, 9000.0, -2.0, 0.707},
+};
+static const int LIMITER_THRESHOLD = 29204;
+static const int LOOKAHEAD = 64;
+
+static const double MAX_ERROR_LSB = 2.0;
+// The gain ramps across the lookahead, so it moves at most full scale / LOOKAHEAD
+// per frame; the slack covers output rounding and EQ error at the measured frames.
+static const double MAX_GAIN_STEP = 1.0 / LOOKAHEAD + 0.002;
+static const double GAIN_MIN_LEVEL = 4000;  // Reference level below which gain is too noisy to read
+
+struct RefBiquad {
+  double b0, b1, b2, a1, a2;
+  double x1, x2, y1, y2;
+
+  double run(double x) {
+    double y = b0 * x + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+    x2 = x1; x1 = x;
+    y2 = y1; y1 = y;
+    return y;
+  }
+};
+
+// Written out independently of dsp.cpp from the RBJ audio EQ cookbook
+static RefBiquad design(const RefBand& band, double fs) {
+  double A = pow(10.0, band.gainDb / 40.0);
+  double w0 = 2.0 * M_PI * band.freqHz / fs;
+  double c = cos(w0);
+  double alpha = sin(w0) / (2.0 * band.q);
+  double sq = 2.0 * sqrt(A) * alpha;
+  double b0, b1, b2, a0, a1, a2;
+  switch (band.type) {
+    case REF_HIGH_PASS:
+      b0 = (1 + c) / 2; b1 = -(1 + c); b2 = (1 + c) / 2;
+      a0 = 1 + alpha; a1 = -2 * c; a2 = 1 - alpha;
+      break;
+    case REF_LOW_SHELF:
+      b0 = A * ((A + 1) - (A - 1) * c + sq); b1 = 2 * A * ((A - 1) - (A + 1) * c);
+      b2 = A * ((A + 1) - (A - 1) * c - sq);
+      a0 = (A + 1) + (A - 1) * c + sq; a1 = -2 * ((A - 1) + (A + 1) * c);
+      a2 = (A + 1) + (A - 1) * c - sq;
+      break;
+    case REF_PEAKING:
+      b0 = 1 + alpha * A; b1 = -2 * c; b2 = 1 - alpha * A;
+      a0 = 1 + alpha / A; a1 = -2 * c; a2 = 1 - alpha / A;
+      break;
+    case REF_HIGH_SHELF:
+    default:
+      b0 = A * ((A + 1) + (A - 1) * c + sq); b1 = -2 * A * ((A - 1) + (A + 1) * c);
+      b2 = A * ((A + 1) + (A - 1) * c - sq);
+      a0 = (A + 1) - (A - 1) * c + sq; a1 = 2 * ((A - 1) - (A + 1) * c);
+      a2 = (A + 1) - (A - 1) * c - sq;
+      break;
+  }
+  return RefBiquad{b0 / a0, b1 / a0, b2 / a0, a1 / a0, a2 / a0, 0, 0, 0, 0};
+}
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+  printf("%s %s\n", ok ? "PASS" : "FAIL", what);
+  if (!ok) failures++;
+}
+
+// Feed interleaved stereo through dsp_process in irregular block sizes, as
+// the Audio library does
+static void process_chunked(std::vector<int16_t>& pcm, uint32_t frames) {
+  srand(7);
+  uint32_t offset = 0;
+  while (offset < frames) {
+    uint32_t n = 1 + rand() % 400;
+    if (offset + n > frames) n = frames - offset;
+    dsp_process(&pcm[offset * 2], n, 2);
+    offset += n;
+  }
+}
+
+// Run interleaved stereo through the double cascade, one vector per channel
+static void run_reference(const std::vector<int16_t>& pcm, uint32_t frames, uint32_t fs,
+                          std::vector<double> ref[2]) {
+  for (int ch = 0; ch < 2; ch++) {
+    ref[ch].resize(frames);
+    for (uint32_t i = 0; i < frames; i++) ref[ch][i] = pcm[i * 2 + ch];
+    for (const RefBand& band : refBands) {
+      RefBiquad bq = design(band, fs);
+      for (uint32_t i = 0; i < frames; i++) ref[ch][i] = bq.run(ref[ch][i]);
+    }
+  }
+}
+
+// Below the limiter threshold the chain must match the double cascade,
+// delayed by the lookahead, to within MAX_ERROR_LSB
+static void test_eq_matches_reference(uint32_t fs) {
+  const uint32_t frames = fs * 2;
+  std::vector<int16_t> pcm(frames * 2);
+  std::vector<double> ref[2];
+
+  srand(1);
+  for (uint32_t i = 0; i < frames; i++) {
+    double t = (double)i / fs;
+    double left = 3000 * sin(2 * M_PI * 440 * t) + 2000 * sin(2 * M_PI * 60 * t) + (rand() % 2000 - 1000);
+    double right = 2500 * sin(2 * M_PI * 3000 * t) + 1500 * sin(2 * M_PI * 11000 * t) + (rand() % 2000 - 1000);
+    pcm[i * 2] = (int16_t)lround(left);
+    pcm[i * 2 + 1] = (int16_t)lround(right);
+  }
+  run_reference(pcm, frames, fs, ref);
+
+  dsp_setup(fs);
+  process_chunked(pcm, frames);
+
+  double maxError = 0;
+  double peak = 0;
+  for (int ch = 0; ch < 2; ch++) {
+    for (uint32_t i = LOOKAHEAD; i < frames; i++) {
+      double e = fabs(pcm[i * 2 + ch] - ref[ch][i - LOOKAHEAD]);
+      if (e > maxError) maxError = e;
+      if (fabs(ref[ch][i]) > peak) peak = fabs(ref[ch][i]);
+    }
+  }
+
+  char what[128];
+  snprintf(what, sizeof(what), "EQ at %u Hz: max error %.2f LSB (limit %.1f, reference peak %.0f)",
+           fs, maxError, MAX_ERROR_LSB, peak);
+  check(peak < LIMITER_THRESHOLD && maxError <= MAX_ERROR_LSB, what);
+}
+
+// Loud bursts after quiet passages are the worst case for the attack: the
+// output must never exceed the threshold, and the gain (output over the
+// delayed reference) must ramp rather than step
+static void test_limiter(const char* name, double (*signal)(uint32_t, uint32_t)) {
+  const uint32_t fs = 44100;
+  const uint32_t frames = fs * 2;
+  std::vector<int16_t> pcm(frames * 2);
+  for (uint32_t i = 0; i < frames; i++) {
+    double v = signal(i, fs);
+    if (v > 32767) v = 32767;
+    if (v < -32768) v = -32768;
+    pcm[i * 2] = (int16_t)lround(v);
+    pcm[i * 2 + 1] = (int16_t)lround(-v * 0.8);
+  }
+  std::vector<double> ref[2];
+  run_reference(pcm, frames, fs, ref);
+
+  dsp_setup(fs);
+  process_chunked(pcm, frames);
+
+  int peak = 0;
+  for (uint32_t i = 0; i < frames * 2; i++) {
+    if (abs(pcm[i]) > peak) peak = abs(pcm[i]);
+  }
+  char what[128];
+  snprintf(what, sizeof(what), "limiter, %s: peak %d (threshold %d)", name, peak, LIMITER_THRESHOLD);
+  check(peak <= LIMITER_THRESHOLD, what);
+
+  double maxStep = 0;
+  for (int ch = 0; ch < 2; ch++) {
+    for (uint32_t i = LOOKAHEAD + 1; i < frames; i++) {
+      double r0 = ref[ch][i - 1 - LOOKAHEAD], r1 = ref[ch][i - LOOKAHEAD];
+      if (fabs(r0) < GAIN_MIN_LEVEL || fabs(r1) < GAIN_MIN_LEVEL) continue;
+      double step = fabs(pcm[i * 2 + ch] / r1 - pcm[(i - 1) * 2 + ch] / r0);
+      if (step > maxStep) maxStep = step;
+    }
+  }
+  snprintf(what, sizeof(what), "limiter, %s: gain step %.4f/frame (limit %.4f)", name, maxStep, MAX_GAIN_STEP);
+  check(maxStep <= MAX_GAIN_STEP, what);
+}
+
+static double sine_burst(uint32_t i, uint32_t fs) {
+  return 32000 * sin(2 * M_PI * 1000 * i / fs) * (i > fs / 2 ? 1.0 : 0.1);
+}
+
+static double bass_burst(uint32_t i, uint32_t fs) {
+  return 32767 * sin(2 * M_PI * 120 * i / fs) * ((i / (fs / 4)) % 2 ? 1.0 : 0.05);
+}
+
+// A tone just below the threshold with one full-scale click: the gain must
+// glide down ahead of the click, not step on the tone
+static double tone_and_click(uint32_t i, uint32_t fs) {
+  return 23800 * sin(2 * M_PI * 1000 * i / fs) + (i == fs ? 32767 : 0);
+}
+
+static double clicks(uint32_t i, uint32_t fs) {
+  return (i % (fs / 10)) < 3 ? 32767 : 0;
+}
+
+static double square_wave(uint32_t i, uint32_t fs) {
+  return (i / (fs / 200)) % 2 ? 32767 : -32768;
+}
+
+int main() {
+  test_eq_matches_reference(44100);
+  test_eq_matches_reference(48000);
+  test_eq_matches_reference(22050);
+  test_limiter("1 kHz sine burst", sine_burst);
+  test_limiter("120 Hz gated bass", bass_burst);
+  test_limiter("1 kHz tone and click", tone_and_click);
+  test_limiter("full-scale clicks", clicks);
+  test_limiter("full-scale square", square_wave);
+
+  if (failures > 0) {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("all DSP checks passed\n");
+  return 0;
+}
@@ -0,0 +1,218 @@
+// Replays network throughput traces through the power governor policy
+// (ESP_Radio_Ortho/power_policy.cpp) and reports estimated energy per
+// clock/modem state and underrun risk, against a fixed 240 MHz baseline.
+//
+// Usage: power_sim [--buffer BYTES] [--kbps STREAM_KBPS] [trace.csv ...]
+//
+// A trace is CSV with one "time_ms,link_kbps" sample per line ('#' starts a
+// comment); the link throughput holds until the next sample and the trace
+// ends at its last sample. Other lines are skipped, so a serial capture from a
+// device built with POWER_TRACE 1 (debug_config.h) replays directly. Without
+// trace files, built-in synthetic traces are replayed.
+
+#include "power_policy.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// --- Model (estimates for an ESP32-S3 module at 3.3 V; adjust to measurements) ---
+static const double SUPPLY_VOLTS = 3.3;
+static const double CPU_IDLE_MA[POWER_CPU_STEP_COUNT] = {20.0, 27.0, 37.0};
+static const double CPU_BUSY_EXTRA_MA[POWER_CPU_STEP_COUNT] = {8.0, 15.0, 23.0};
+static const double MODEM_MIN_MA = 45.0;         // WIFI_PS_MIN_MODEM average while streaming
+static const double MODEM_MAX_MA = 20.0;         // WIFI_PS_MAX_MODEM average
+static const double MODEM_MAX_THROUGHPUT = 0.5;  // Share of link throughput left in MAX modem sleep
+static const double DECODE_CYCLES_PER_SEC = 30e6;  // MP3 decode cost per second of 128 kbit/s audio
+
+static const int TICK_MS = 10;  // Main loop period
+
+struct TracePoint {
+  long timeMs;
+  double kbps;
+};
+
+struct Trace {
+  std::string name;
+  std::vector<TracePoint> points;
+};
+
+struct SimResult {
+  double energyMj[POWER_CPU_STEP_COUNT][2];  // [clock step][modem deep sleep]
+  double timeMs[POWER_CPU_STEP_COUNT][2];
+  int evals;
+  int underrunEvals;  // Evaluation intervals in which the buffer hit zero
+  int minFillPercent;
+};
+
+static double link_kbps_at(const Trace& trace, long t) {
+  double kbps = trace.points.front().kbps;
+  for (const TracePoint& p : trace.points) {
+    if (p.timeMs > t) break;
+    kbps = p.kbps;
+  }
+  return kbps;
+}
+
+// governed = false replays the pre-governor behaviour: 240 MHz, MIN modem sleep
+static SimResult simulate(const Trace& trace, double bufferBytes, double streamKbps, bool governed) {
+  SimResult r;
+  memset(&r, 0, sizeof(r));
+  r.minFillPercent = 100;
+
+  PowerPolicy policy;
+  power_policy_reset(policy);
+
+  const double streamBytesPerMs = streamKbps * 1000.0 / 8.0 / 1000.0;
+  double buffer = 0.0;
+  bool prebuffered = false;      // Playback starts once the buffer is half full
+  bool hitZeroThisEval = false;
+  double busyMsThisEval = 0.0;
+  int loadPercent = 0;
+  long end = trace.points.back().timeMs;
+
+  for (long t = 0; t < end; t += TICK_MS) {
+    double mhz = powerCpuStepsMhz[policy.cpuStep];
+
+    // Network fills the buffer
+    double link = link_kbps_at(trace, t) * 1000.0 / 8.0 / 1000.0 * TICK_MS;
+    if (policy.modemDeepSleep) link *= MODEM_MAX_THROUGHPUT;
+    buffer += link;
+    if (buffer > bufferBytes) buffer = bufferBytes;
+    if (!prebuffered && buffer >= bufferBytes / 2) prebuffered = true;
+
+    // Decoder drains it, limited by the CPU time available at this clock
+    double busyMs = 0.0;
+    if (prebuffered) {
+      double realtimeShare = DECODE_CYCLES_PER_SEC / (mhz * 1e6);  // CPU share for real time
+      double want = streamBytesPerMs * TICK_MS;
+      if (realtimeShare > 1.0) want /= realtimeShare;
+      double got = want < buffer ? want : buffer;
+      buffer -= got;
+      busyMs = TICK_MS * realtimeShare * (got / (streamBytesPerMs * TICK_MS));
+      if (busyMs > TICK_MS) busyMs = TICK_MS;
+      if (got < streamBytesPerMs * TICK_MS) hitZeroThisEval = true;
+    }
+    busyMsThisEval += busyMs;
+
+    // Energy for this tick
+    int modem = policy.modemDeepSleep ? 1 : 0;
+    double ma = CPU_IDLE_MA[policy.cpuStep] + CPU_BUSY_EXTRA_MA[policy.cpuStep] * busyMs / TICK_MS +
+                (modem ? MODEM_MAX_MA : MODEM_MIN_MA);
+    r.energyMj[policy.cpuStep][modem] += ma * SUPPLY_VOLTS * TICK_MS / 1000.0;
+    r.timeMs[policy.cpuStep][modem] += TICK_MS;
+
+    // Governor evaluation
+    if ((t + TICK_MS) % POWER_EVAL_INTERVAL_MS == 0) {
+      int fill = (int)(buffer * 100.0 / bufferBytes);
+      loadPercent = (int)(busyMsThisEval * 100.0 / POWER_EVAL_INTERVAL_MS);
+      if (prebuffered && fill < r.minFillPercent) r.minFillPercent = fill;
+      r.evals++;
+      if (hitZeroThisEval) r.underrunEvals++;
+      if (governed) power_policy_step(policy, true, fill, loadPercent);
+      hitZeroThisEval = false;
+      busyMsThisEval = 0.0;
+    }
+  }
+  return r;
+}
+
+static double total_mj(const SimResult& r) {
+  double total = 0.0;
+  for (int s = 0; s < POWER_CPU_STEP_COUNT; s++) total += r.energyMj[s][0] + r.energyMj[s][1];
+  return total;
+}
+
+static void report(const Trace& trace, double bufferBytes, double streamKbps) {
+  SimResult gov = simulate(trace, bufferBytes, streamKbps, true);
+  SimResult base = simulate(trace, bufferBytes, streamKbps, false);
+  double govMj = total_mj(gov);
+  double baseMj = total_mj(base);
+  double seconds = trace.points.back().timeMs / 1000.0;
+
+  printf("== %s (%.0f s)\n", trace.name.c_str(), seconds);
+  printf("   state              time     energy\n");
+  for (int s = 0; s < POWER_CPU_STEP_COUNT; s++) {
+    for (int m = 0; m < 2; m++) {
+      if (gov.timeMs[s][m] == 0) continue;
+      printf("   %3u MHz %-8s %6.1f%%  %8.1f mJ\n", powerCpuStepsMhz[s], m ? "MAX" : "MIN",
+             gov.timeMs[s][m] * 100.0 / (seconds * 1000.0), gov.energyMj[s][m]);
+    }
+  }
+  printf("   governor: %.2f mWh, %d/%d intervals hit zero, min fill %d%%\n",
+         govMj / 3600.0, gov.underrunEvals, gov.evals, gov.minFillPercent);
+  printf("   baseline: %.2f mWh, %d/%d intervals hit zero, min fill %d%%\n",
+         baseMj / 3600.0, base.underrunEvals, base.evals, base.minFillPercent);
+  printf("   saving: %.1f%%\n\n", baseMj > 0 ? (baseMj - govMj) * 100.0 / baseMj : 0.0);
+}
+
+// --- Synthetic traces ---
+
+static Trace synthetic(const char* name, long durationMs, double (*kbpsAt)(long, unsigned&)) {
+  Trace trace;
+  trace.name = name;
+  unsigned seed = 1;
+  for (long t = 0; t <= durationMs; t += 1000) {
+    trace.points.push_back({t, kbpsAt(t, seed)});
+  }
+  return trace;
+}
+
+static double steady(long, unsigned&) { return 1000.0; }
+static double jittery(long, unsigned& seed) { return 50.0 + rand_r(&seed) % 1500; }
+static double dropouts(long t, unsigned&) { return (t % 60000) < 55000 ? 1000.0 : 0.0; }
+static double congested(long t, unsigned&) { return (t / 10000) % 2 ? 140.0 : 200.0; }
+
+static bool load_trace(const char* path, Trace& trace) {
+  FILE* f = fopen(path, "r");
+  if (f == nullptr) {
+    fprintf(stderr, "cannot open %s\n", path);
+    return false;
+  }
+  trace.name = path;
+  char line[256];
+  while (fgets(line, sizeof(line), f)) {
+    if (line[0] == '#' || line[0] == '\n') continue;
+    long t;
+    double kbps;
+    if (sscanf(line, "%ld,%lf", &t, &kbps) == 2) trace.points.push_back({t, kbps});
+  }
+  fclose(f);
+  if (trace.points.size() < 2) {
+    fprintf(stderr, "%s: need at least two samples\n", path);
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  double bufferBytes = 65536;
+  double streamKbps = 128;
+  std::vector<Trace> traces;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--buffer") == 0 && i + 1 < argc) {
+      bufferBytes = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--kbps") == 0 && i + 1 < argc) {
+      streamKbps = atof(argv[++i]);
+    } else {
+      Trace trace;
+      if (!load_trace(argv[i], trace)) return 1;
+      traces.push_back(trace);
+    }
+  }
+  if (traces.empty()) {
+    traces.push_back(synthetic("synthetic: steady 1 Mbit/s", 600000, steady));
+    traces.push_back(synthetic("synthetic: jittery 50-1550 kbit/s", 600000, jittery));
+    traces.push_back(synthetic("synthetic: 5 s dropout every minute", 600000, dropouts));
+    traces.push_back(synthetic("synthetic: congested 140/200 kbit/s", 600000, congested));
+  }
+
+  printf("buffer %.0f bytes, stream %.0f kbit/s\n\n", bufferBytes, streamKbps);
+  for (const Trace& trace : traces) {
+    report(trace, bufferBytes, streamKbps);
+  }
+  return 0;
+}
@@ -0,0 +1,139 @@
+// Checks ESP_Radio_Ortho/rumble_queue.cpp: a flood of pulses is dropped and
+// counted without ever blocking the producer, queued pulses are merged into
+// one write per pulse window, latency is measured from the time the caller
+// passed in, and a producer thread racing the consumer loses no pulse
+// unaccounted. Exits non-zero on failure.
+
+#include "rumble_queue.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+// Generous: a push is a few loads and stores, a wait of any length would show
+static const double MAX_AVERAGE_PUSH_US = 10.0;
+static const int FLOOD_PULSES = 100000;
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+  printf("%s %s\n", ok ? "PASS" : "FAIL", what);
+  if (!ok) failures++;
+}
+
+static int64_t wall_us() {
+  using namespace std::chrono;
+  return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Virtual clock; records every write
+class TestDriver : public RumbleDriver {
+ public:
+  int64_t clockUs = 0;
+  bool writable = true;
+  bool wallClock = false;
+  std::vector<RumblePulse> writes;
+
+  int64_t nowUs() override { return wallClock ? wall_us() : clockUs; }
+  bool canWrite() override { return writable; }
+  void write(const RumblePulse& pulse) override { writes.push_back(pulse); }
+};
+
+static RumbleQueue queue;
+
+static void test_flood() {
+  rumble_queue_reset(queue);
+  int accepted = 0;
+  int64_t start = wall_us();
+  for (int i = 0; i < FLOOD_PULSES; i++) {
+    if (rumble_queue_push(queue, 25, 3, i)) accepted++;
+  }
+  double averageUs = (double)(wall_us() - start) / FLOOD_PULSES;
+  printf("     %d pushes, %d accepted, %u dropped, %.3f us per push\n",
+         FLOOD_PULSES, accepted, queue.stats.dropped, averageUs);
+  check(accepted == RUMBLE_QUEUE_LENGTH, "flood: only the queue length is accepted");
+  check(queue.stats.dropped == (uint32_t)(FLOOD_PULSES - RUMBLE_QUEUE_LENGTH), "flood: every other pulse counted as dropped");
+  check(queue.stats.queued == RUMBLE_QUEUE_LENGTH, "flood: queued count matches");
+  check(averageUs < MAX_AVERAGE_PUSH_US, "flood: push never blocks on a full queue");
+
+  TestDriver driver;
+  driver.clockUs = FLOOD_PULSES;
+  check(rumble_queue_service(queue, driver) && driver.writes.size() == 1, "flood: drained in one write");
+  check(rumble_queue_push(queue, 25, 3, 0), "flood: queue accepts again after draining");
+}
+
+static void test_coalesce() {
+  rumble_queue_reset(queue);
+  TestDriver driver;
+  rumble_queue_push(queue, 25, 3, 1000);
+  rumble_queue_push(queue, 60, 12, 1200);
+  rumble_queue_push(queue, 25, 3, 1400);
+  driver.clockUs = 3500;
+  bool wrote = rumble_queue_service(queue, driver);
+  check(wrote && driver.writes.size() == 1, "coalesce: three pulses, one write");
+  check(driver.writes[0].strength == 60 && driver.writes[0].duration == 12, "coalesce: strongest and longest pulse wins");
+  check(queue.stats.coalesced == 2, "coalesce: merged pulses counted");
+  check(queue.stats.latencyMinUs == 2500 && queue.stats.latencyMaxUs == 2500,
+        "latency: measured from the earliest caller timestamp");
+
+  // The 120 ms pulse is still playing: the next one waits for it
+  rumble_queue_push(queue, 25, 3, 4000);
+  driver.clockUs = 3500 + 119000;
+  check(!rumble_queue_service(queue, driver), "busy: no write while the previous pulse plays");
+  driver.clockUs = 3500 + 120000;
+  check(rumble_queue_service(queue, driver) && driver.writes.size() == 2, "busy: written once it has finished");
+  check(queue.stats.latencyMaxUs == 3500 + 120000 - 4000, "latency: includes the wait for the previous pulse");
+}
+
+static void test_not_writable() {
+  rumble_queue_reset(queue);
+  TestDriver driver;
+  rumble_queue_push(queue, 25, 3, 0);
+  rumble_queue_push(queue, 25, 3, 0);
+  driver.writable = false;
+  check(!rumble_queue_service(queue, driver) && driver.writes.empty(), "disconnected: nothing written");
+  driver.writable = true;
+  check(!rumble_queue_service(queue, driver), "disconnected: queued pulses discarded");
+}
+
+// The BLE task pushes while the main loop services, as on the device
+static void test_concurrent() {
+  rumble_queue_reset(queue);
+  TestDriver driver;
+  driver.wallClock = true;
+  std::atomic<bool> done(false);
+  std::thread producer([&] {
+    for (int i = 0; i < FLOOD_PULSES; i++) {
+      rumble_queue_push(queue, (uint8_t)(i % 100), 0, wall_us());
+      if (i % 4 == 0) std::this_thread::yield();  // Let the consumer interleave
+    }
+    done = true;
+  });
+  while (!done) {
+    rumble_queue_service(queue, driver);
+  }
+  producer.join();
+  rumble_queue_service(queue, driver);
+
+  const RumbleStats& s = queue.stats;
+  printf("     %u queued, %u dropped, %u sent, %u coalesced\n", s.queued, s.dropped, s.sent, s.coalesced);
+  check(s.queued + s.dropped == (uint32_t)FLOOD_PULSES, "concurrent: every push queued or dropped");
+  check(s.sent + s.coalesced == s.queued, "concurrent: every queued pulse sent or merged");
+  check(s.sent == driver.writes.size(), "concurrent: one write per sent pulse");
+  check(s.latencyMinUs >= 0, "concurrent: latency never negative");
+}
+
+int main() {
+  test_flood();
+  test_coalesce();
+  test_not_writable();
+  test_concurrent();
+  if (failures > 0) {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("all rumble queue checks passed\n");
+  return 0;
+}
@@ -0,0 +1,11 @@
+// Minimal stand-in for the Arduino core, enough to compile the sketch's
+// hardware-independent modules on the host.
+#ifndef HOST_ARDUINO_STUB_H
+#define HOST_ARDUINO_STUB_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+#endif // HOST_ARDUINO_STUB_H
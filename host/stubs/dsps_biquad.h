@@ -0,0 +1,22 @@
+// Stand-in for esp-dsp's dsps_biquad.h: a port of its plain C kernel
+// (dsps_biquad_f32_ansi, direct form II) so the sketch's esp-dsp EQ path can
+// be built and tested on the host. On the S3 the same call runs the
+// hand-written aes3 kernel.
+#ifndef HOST_DSPS_BIQUAD_STUB_H
+#define HOST_DSPS_BIQUAD_STUB_H
+
+typedef int esp_err_t;
+#define ESP_OK 0
+
+// coef = {b0, b1, b2, a1, a2}, w = two words of filter state
+static inline esp_err_t dsps_biquad_f32(const float* input, float* output, int len, float* coef, float* w) {
+  for (int i = 0; i < len; i++) {
+    float d0 = input[i] - coef[3] * w[0] - coef[4] * w[1];
+    output[i] = coef[0] * d0 + coef[1] * w[0] + coef[2] * w[1];
+    w[1] = w[0];
+    w[0] = d0;
+  }
+  return ESP_OK;
+}
+
+#endif // HOST_DSPS_BIQUAD_STUB_H
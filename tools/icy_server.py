@@ -0,0 +1,298 @@
+#!/usr/bin/env python3
+"""Scriptable ICY (SHOUTcast-style) test server for ESP_Radio_Ortho soak runs.
+
+Streams MP3 files over HTTP/1.0 with ICY metadata, paced in real time, and
+follows a script that degrades the stream so reconnect and underrun handling
+can be exercised on demand. Point the radio at it with STREAM_URL_OVERRIDE in
+debug_config.h.
+
+    icy_server.py --file 128=music128.mp3 --file 64=music64.mp3 \\
+                  --script flaky.txt --loop
+
+Script lines are "<seconds> <action> [argument]", with the time counted from
+server start ('#' starts a comment). With --loop the script restarts after
+the last line. Actions apply to every connected client:
+
+    normal             send at the bitrate of the current file, no jitter
+    throttle <kbps>    send at this rate instead (below the bitrate = underruns);
+                       must be above 0, use 'stall' to send nothing
+    jitter <ms>        hold each chunk back by a random 0..ms (up to 1000),
+                       keeping the average rate: bursty delivery
+    stall              keep the connection open but send nothing
+    reset              abort all connections with a TCP reset
+    down / up          refuse new connections with 503 / accept them again
+    bitrate <kbps>     switch to the file registered for that bitrate, mid-stream
+    title <text>       change the StreamTitle metadata
+
+Example script:
+    0    normal
+    120  throttle 64
+    180  normal
+    300  stall
+    320  normal
+    400  reset
+    460  bitrate 64
+    600  bitrate 128
+"""
+
+import argparse
+import random
+import socket
+import struct
+import sys
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+CHUNK = 1024
+METAINT = 16000
+
+
+def log(message):
+    print(f"{time.strftime('%H:%M:%S')} {message}", flush=True)
+
+
+class StreamState:
+    """What the script has set; read by every client thread."""
+
+    def __init__(self, files, bitrate):
+        self.lock = threading.Lock()
+        self.files = files            # kbps -> bytes
+        self.bitrate = bitrate
+        self.throttle_kbps = None
+        self.jitter_ms = 0.0
+        self.stalled = False
+        self.down = False
+        self.title = "ESP_Radio_Ortho test stream"
+        self.reset_generation = 0
+
+    def apply(self, action, arg):
+        with self.lock:
+            if action == "normal":
+                self.throttle_kbps = None
+                self.jitter_ms = 0.0
+                self.stalled = False
+            elif action == "throttle":
+                kbps = float(arg)
+                if kbps <= 0:
+                    raise ValueError("throttle needs a rate above 0 kbit/s (use 'stall' to send nothing)")
+                self.throttle_kbps = kbps
+                self.stalled = False
+            elif action == "jitter":
+                self.jitter_ms = min(float(arg), 1000.0)
+            elif action == "stall":
+                self.stalled = True
+            elif action == "reset":
+                self.reset_generation += 1
+            elif action == "down":
+                self.down = True
+            elif action == "up":
+                self.down = False
+            elif action == "bitrate":
+                kbps = int(arg)
+                if kbps not in self.files:
+                    raise ValueError(f"no file registered for {kbps} kbit/s")
+                self.bitrate = kbps
+            elif action == "title":
+                self.title = arg
+            else:
+                raise ValueError(f"unknown action '{action}'")
+
+    def snapshot(self):
+        with self.lock:
+            if self.stalled:
+                rate = 0.0
+            elif self.throttle_kbps is not None:
+                rate = self.throttle_kbps
+            else:
+                rate = self.bitrate
+            return self.bitrate, rate, self.jitter_ms, self.title, self.reset_generation
+
+
+def parse_script(path):
+    steps = []
+    with open(path) as f:
+        for number, line in enumerate(f, 1):
+            line = line.split("#", 1)[0].strip()
+            if not line:
+                continue
+            parts = line.split(None, 2)
+            try:
+                at = float(parts[0])
+            except ValueError:
+                sys.exit(f"{path}:{number}: bad time '{parts[0]}'")
+            action = parts[1] if len(parts) > 1 else ""
+            arg = parts[2] if len(parts) > 2 else None
+            if action in ("throttle", "jitter", "bitrate", "title") and arg is None:
+                sys.exit(f"{path}:{number}: '{action}' needs an argument")
+            if action == "throttle":
+                try:
+                    kbps = float(arg)
+                except ValueError:
+                    sys.exit(f"{path}:{number}: bad rate '{arg}'")
+                if kbps <= 0:
+                    sys.exit(f"{path}:{number}: throttle needs a rate above 0 kbit/s "
+                             "(use 'stall' to send nothing)")
+            steps.append((at, action, arg))
+    steps.sort(key=lambda step: step[0])
+    return steps
+
+
+def run_script(state, steps, loop):
+    if not steps:
+        return
+    length = steps[-1][0]
+    start = time.monotonic()
+    while True:
+        for at, action, arg in steps:
+            delay = start + at - time.monotonic()
+            if delay > 0:
+                time.sleep(delay)
+            try:
+                state.apply(action, arg)
+                log(f"script: {action}{' ' + arg if arg else ''}")
+            except ValueError as e:
+                log(f"script: {e}")
+        if not loop:
+            return
+        # A zero-length script would spin; leave at least a second per pass
+        start += max(length, 1.0)
+
+
+def metadata_block(title):
+    text = f"StreamTitle='{title.replace(chr(39), '')}';".encode("utf-8")[:255 * 16]
+    blocks = (len(text) + 15) // 16
+    return bytes([blocks]) + text.ljust(blocks * 16, b"\0")
+
+
+def make_handler(state, burst_bytes):
+    class IcyHandler(BaseHTTPRequestHandler):
+        protocol_version = "HTTP/1.0"
+
+        def log_message(self, fmt, *args):
+            log(f"{self.client_address[0]} {fmt % args}")
+
+        def finish(self):
+            # The socket is already gone after a scripted reset
+            try:
+                super().finish()
+            except (OSError, ValueError):
+                pass
+
+        def do_GET(self):
+            if state.down:
+                self.send_error(503, "Stream down (script)")
+                return
+            bitrate, _, _, title, generation = state.snapshot()
+            want_meta = self.headers.get("Icy-MetaData") == "1"
+
+            self.send_response(200)
+            self.send_header("Content-Type", "audio/mpeg")
+            self.send_header("icy-name", "ESP_Radio_Ortho test server")
+            self.send_header("icy-br", str(bitrate))
+            if want_meta:
+                self.send_header("icy-metaint", str(METAINT))
+            self.end_headers()
+
+            try:
+                self.stream(want_meta, generation, burst_bytes)
+            except (BrokenPipeError, ConnectionResetError):
+                log(f"{self.client_address[0]} disconnected")
+
+        def stream(self, want_meta, generation, burst):
+            position = 0          # In the current file
+            until_meta = METAINT
+            sent_title = None
+            current = None
+            next_send = time.monotonic()
+            while True:
+                bitrate, rate, jitter_ms, title, gen = state.snapshot()
+                if gen != generation:
+                    # SO_LINGER 0: close() sends RST instead of FIN
+                    self.connection.setsockopt(socket.SOL_SOCKET, socket.SO_LINGER,
+                                               struct.pack("ii", 1, 0))
+                    self.connection.close()
+                    log(f"{self.client_address[0]} reset by script")
+                    return
+                if bitrate != current:
+                    current = bitrate
+                    position = 0
+                data = state.files[current]
+
+                if rate <= 0:
+                    time.sleep(0.05)
+                    next_send = time.monotonic()
+                    continue
+
+                size = min(CHUNK, until_meta if want_meta else CHUNK)
+                chunk = data[position:position + size]
+                if len(chunk) < size:
+                    chunk += data[:size - len(chunk)]
+                position = (position + size) % len(data)
+                self.wfile.write(chunk)
+
+                if want_meta:
+                    until_meta -= size
+                    if until_meta == 0:
+                        # Only send the title when it changed, as real servers do
+                        self.wfile.write(metadata_block(title) if title != sent_title else b"\0")
+                        sent_title = title
+                        until_meta = METAINT
+
+                # The first burst_bytes go out unpaced to fill the client buffer
+                if burst > 0:
+                    burst -= size
+                    next_send = time.monotonic()
+                    continue
+                next_send += size * 8 / (rate * 1000)
+                # Jitter delays this chunk only; the schedule itself is kept,
+                # so later chunks catch up back to back
+                late = random.uniform(0, jitter_ms) / 1000 if jitter_ms else 0.0
+                delay = next_send + late - time.monotonic()
+                if delay > 0:
+                    time.sleep(delay)
+                elif delay < -1.0 - late:
+                    next_send = time.monotonic()  # Do not catch up after a stall
+
+    return IcyHandler
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0],
+                                     formatter_class=argparse.RawDescriptionHelpFormatter,
+                                     epilog="\n".join(__doc__.splitlines()[2:]))
+    parser.add_argument("--file", action="append", required=True, metavar="KBPS=PATH",
+                        help="MP3 file and its bitrate; repeat for bitrate changes")
+    parser.add_argument("--script", help="degradation script (see above)")
+    parser.add_argument("--loop", action="store_true", help="repeat the script")
+    parser.add_argument("--host", default="0.0.0.0")
+    parser.add_argument("--port", type=int, default=8000)
+    parser.add_argument("--burst-kb", type=int, default=64,
+                        help="sent unpaced at connect, like a real server (default 64)")
+    args = parser.parse_args()
+
+    files = {}
+    for spec in args.file:
+        kbps, sep, path = spec.partition("=")
+        if not sep or not kbps.isdigit():
+            parser.error(f"--file expects KBPS=PATH, got '{spec}'")
+        with open(path, "rb") as f:
+            files[int(kbps)] = f.read()
+        if not files[int(kbps)]:
+            parser.error(f"{path} is empty")
+
+    state = StreamState(files, next(iter(files)))
+    steps = parse_script(args.script) if args.script else []
+
+    server = ThreadingHTTPServer((args.host, args.port), make_handler(state, args.burst_kb * 1024))
+    server.daemon_threads = True
+    log(f"serving on http://{args.host}:{args.port}/ at {state.bitrate} kbit/s")
+    threading.Thread(target=run_script, args=(state, steps, args.loop), daemon=True).start()
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,258 @@
+#!/usr/bin/env python3
+"""Build and validate configuration images for ESP_Radio_Ortho.
+
+The image layout mirrors struct RadioConfig in ESP_Radio_Ortho/config.h and is
+read in place from the "radiocfg" partition (see partitions.csv).
+
+Build an image from JSON:
+    mkradiocfg.py build radio.json -o radiocfg.bin
+
+Validate an existing image:
+    mkradiocfg.py check radiocfg.bin
+
+Both exit with status 1 and an error message on a bad config or image.
+The scan interval and window must be 3-10240 ms (the BLE range of
+2.5 ms-10.24 s in whole milliseconds), with the window no longer than the
+interval.
+
+Flash it (offset of "radiocfg" in partitions.csv):
+    esptool.py write_flash 0x670000 radiocfg.bin
+
+Example radio.json:
+    {
+      "ssid": "MokuMoku",
+      "password": "...",
+      "default_volume": 10,
+      "default_preset": 0,
+      "scan_interval_ms": 1349,
+      "scan_window_ms": 449,
+      "service_uuid": "00400000-0000-1000-8000-00805f9b34fb",
+      "report_char_uuid": "0x2A4D",
+      "presets": [
+        {"name": "Deutschlandfunk",
+         "url": "https://st01.sslstream.dlf.de/dlf/01/128/mp3/stream.mp3?aggregator=web"}
+      ],
+      "bonds": [{"address": "44:16:22:E3:CB:B3", "random": false}]
+    }
+"""
+
+import argparse
+import json
+import struct
+import sys
+import uuid
+import zlib
+
+MAGIC = 0x47464352  # "RCFG"
+VERSION = 1
+MAX_PRESETS = 8
+MAX_BONDS = 4
+SCAN_MIN_MS = 3          # BLE allows 2.5 ms-10.24 s; must match config.h
+SCAN_MAX_MS = 10240
+PARTITION_SIZE = 0x1000
+
+HEADER = struct.Struct("<IHHI")             # magic, version, size, crc32
+BODY = struct.Struct("<BBBBHH36s64s16sHH")   # counts, defaults, scan, wifi, uuids
+PRESET = struct.Struct("<32s224s")
+BOND = struct.Struct("<6sBB")
+IMAGE_SIZE = HEADER.size + BODY.size + MAX_PRESETS * PRESET.size + MAX_BONDS * BOND.size
+assert IMAGE_SIZE == 2220, "layout out of sync with config.h"
+
+
+def integer(value, field):
+    # JSON true/false are ints to Python; reject them along with floats and strings
+    if isinstance(value, bool) or not isinstance(value, int):
+        raise ValueError(f"{field} must be an integer, got {value!r}")
+    return value
+
+
+def scan_problem(interval, window):
+    """Why a scan interval/window pair is invalid, or None."""
+    if not SCAN_MIN_MS <= interval <= SCAN_MAX_MS:
+        return f"scan interval {interval} ms out of range {SCAN_MIN_MS}-{SCAN_MAX_MS} ms"
+    if not SCAN_MIN_MS <= window <= SCAN_MAX_MS:
+        return f"scan window {window} ms out of range {SCAN_MIN_MS}-{SCAN_MAX_MS} ms"
+    if window > interval:
+        return f"scan window {window} ms longer than scan interval {interval} ms"
+    return None
+
+
+def fixed_string(value, size, field):
+    if not isinstance(value, str):
+        raise ValueError(f"{field} must be a string, got {value!r}")
+    data = value.encode("utf-8")
+    if len(data) >= size:
+        raise ValueError(f"{field} is {len(data)} bytes, at most {size - 1} allowed")
+    return data
+
+
+def parse_address(text):
+    parts = text.split(":") if isinstance(text, str) else []
+    try:
+        address = bytes(int(p, 16) for p in parts)
+    except ValueError:
+        address = b""
+    if len(address) != 6:
+        raise ValueError(f"bad controller address {text!r}")
+    return address
+
+
+def objects(cfg, field):
+    items = cfg.get(field, [])
+    if not isinstance(items, list) or not all(isinstance(item, dict) for item in items):
+        raise ValueError(f"{field} must be a list of objects")
+    return items
+
+
+def build(cfg):
+    if not isinstance(cfg, dict):
+        raise ValueError("config must be a JSON object")
+    presets = objects(cfg, "presets")
+    bonds = objects(cfg, "bonds")
+    if not 1 <= len(presets) <= MAX_PRESETS:
+        raise ValueError(f"need 1-{MAX_PRESETS} presets, got {len(presets)}")
+    if len(bonds) > MAX_BONDS:
+        raise ValueError(f"at most {MAX_BONDS} bonds, got {len(bonds)}")
+    default_preset = integer(cfg.get("default_preset", 0), "default_preset")
+    if not 0 <= default_preset < len(presets):
+        raise ValueError("default_preset out of range")
+    volume = integer(cfg.get("default_volume", 10), "default_volume")
+    if not 0 <= volume <= 21:
+        raise ValueError("default_volume must be 0-21")
+    interval = integer(cfg.get("scan_interval_ms", 1349), "scan_interval_ms")
+    window = integer(cfg.get("scan_window_ms", 449), "scan_window_ms")
+    problem = scan_problem(interval, window)
+    if problem:
+        raise ValueError(problem)
+    report_char = cfg.get("report_char_uuid", "0x2A4D")
+    try:
+        report_char = int(str(report_char), 0)
+    except ValueError:
+        report_char = -1
+    if not 0 <= report_char <= 0xFFFF:
+        raise ValueError(f"report_char_uuid must be a 16-bit UUID, got {cfg.get('report_char_uuid')!r}")
+
+    body = BODY.pack(
+        len(presets), len(bonds), default_preset, volume, interval, window,
+        fixed_string(cfg["ssid"], 36, "ssid"),
+        fixed_string(cfg["password"], 64, "password"),
+        uuid.UUID(str(cfg.get("service_uuid", "00400000-0000-1000-8000-00805f9b34fb"))).bytes[::-1],
+        report_char, 0)
+    for i in range(MAX_PRESETS):
+        if i < len(presets):
+            p = presets[i]
+            body += PRESET.pack(fixed_string(p["name"], 32, f"presets[{i}].name"),
+                                fixed_string(p["url"], 224, f"presets[{i}].url"))
+        else:
+            body += bytes(PRESET.size)
+    for i in range(MAX_BONDS):
+        if i < len(bonds):
+            b = bonds[i]
+            body += BOND.pack(parse_address(b["address"]), 1 if b.get("random") else 0, 0)
+        else:
+            body += bytes(BOND.size)
+
+    return HEADER.pack(MAGIC, VERSION, IMAGE_SIZE, zlib.crc32(body)) + body
+
+
+def check(image):
+    if len(image) < IMAGE_SIZE:
+        return [f"image is {len(image)} bytes, expected at least {IMAGE_SIZE}"]
+    magic, version, size, crc = HEADER.unpack_from(image)
+    errors = []
+    if magic != MAGIC:
+        errors.append(f"bad magic 0x{magic:08x}")
+    if version != VERSION:
+        errors.append(f"unsupported version {version}")
+    if size != IMAGE_SIZE:
+        errors.append(f"size field {size}, expected {IMAGE_SIZE}")
+    actual = zlib.crc32(image[HEADER.size:IMAGE_SIZE])
+    if actual != crc:
+        errors.append(f"CRC mismatch: image 0x{crc:08x}, computed 0x{actual:08x}")
+    fields = BODY.unpack_from(image, HEADER.size)
+    preset_count, bond_count, default_preset, volume, interval, window = fields[:6]
+    ssid, password = fields[6:8]
+    if not 1 <= preset_count <= MAX_PRESETS or default_preset >= preset_count:
+        errors.append("preset count or default preset out of range")
+    if bond_count > MAX_BONDS:
+        errors.append("bond count out of range")
+    if volume > 21:
+        errors.append("default volume out of range")
+    problem = scan_problem(interval, window)
+    if problem:
+        errors.append(problem)
+    # The firmware reads strings in place, so each must end inside its field
+    if b"\0" not in ssid or b"\0" not in password:
+        errors.append("ssid or password not NUL-terminated")
+    offset = HEADER.size + BODY.size
+    for i in range(min(preset_count, MAX_PRESETS)):
+        name, url = PRESET.unpack_from(image, offset + i * PRESET.size)
+        if b"\0" not in name or b"\0" not in url:
+            errors.append(f"preset {i} name or URL not NUL-terminated")
+    return errors
+
+
+def cstr(data):
+    return data.split(b"\0", 1)[0].decode("utf-8")
+
+
+def describe(image):
+    fields = BODY.unpack_from(image, HEADER.size)
+    preset_count, bond_count, default_preset, volume, interval, window, ssid = fields[:7]
+    print(f"ssid: {cstr(ssid)}")
+    print(f"volume: {volume}, scan: {interval}/{window} ms")
+    offset = HEADER.size + BODY.size
+    for i in range(preset_count):
+        name, url = PRESET.unpack_from(image, offset + i * PRESET.size)
+        mark = "*" if i == default_preset else " "
+        print(f"preset {i}{mark} {cstr(name)}: {cstr(url)}")
+    offset += MAX_PRESETS * PRESET.size
+    for i in range(bond_count):
+        address, addr_type, _ = BOND.unpack_from(image, offset + i * BOND.size)
+        kind = "random" if addr_type else "public"
+        print(f"bond {i}: {':'.join(f'{b:02X}' for b in address)} ({kind})")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    sub = parser.add_subparsers(dest="command", required=True)
+    b = sub.add_parser("build", help="build an image from JSON")
+    b.add_argument("json")
+    b.add_argument("-o", "--output", default="radiocfg.bin")
+    c = sub.add_parser("check", help="validate an image")
+    c.add_argument("image")
+    args = parser.parse_args()
+
+    if args.command == "build":
+        try:
+            with open(args.json) as f:
+                image = build(json.load(f))
+        except KeyError as e:
+            print(f"error: {args.json}: missing field {e}", file=sys.stderr)
+            return 1
+        except (OSError, ValueError, struct.error) as e:
+            print(f"error: {args.json}: {e}", file=sys.stderr)
+            return 1
+        # Pad to the partition so stale bytes from an older image never linger
+        with open(args.output, "wb") as f:
+            f.write(image + b"\xff" * (PARTITION_SIZE - len(image)))
+        print(f"wrote {args.output} ({len(image)} byte image)")
+        return 0
+
+    try:
+        with open(args.image, "rb") as f:
+            image = f.read()
+    except OSError as e:
+        print(f"error: {e}", file=sys.stderr)
+        return 1
+    errors = check(image)
+    for error in errors:
+        print(f"error: {error}", file=sys.stderr)
+    if not errors:
+        describe(image)
+        print("image OK")
+    return 1 if errors else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
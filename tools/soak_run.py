@@ -0,0 +1,201 @@
+#!/usr/bin/env python3
+"""Collect SOAK telemetry from ESP_Radio_Ortho over a long run.
+
+Build the sketch with SOAK_TELEMETRY 1 (debug_config.h). The radio then prints
+one "SOAK t=... underruns=... heap=..." line per SOAK_REPORT_INTERVAL_MS. This
+runner reads them from the serial port (needs pyserial) or from a saved log,
+writes them to CSV, and summarises the run: underruns and reconnects per
+hour, heap and largest-block trends, reboots and STUCK reports.
+
+    soak_run.py --port /dev/ttyACM0 --hours 12 --csv soak.csv --log soak.log
+    soak_run.py --port /dev/ttyACM0 --hours 12 \\
+        --server "tools/icy_server.py --file 128=music.mp3 --script flaky.txt --loop"
+    soak_run.py --input soak.log            # summarise a saved log
+
+With --server the command is started first and stopped at the end, so the
+degradation script and the soak share one timeline.
+"""
+
+import argparse
+import csv
+import shlex
+import subprocess
+import sys
+import time
+
+FIELDS = ["t", "underruns", "reconnects", "heap", "heap_min", "largest", "frag",
+          "heap_drift", "largest_drift"]
+BOOT_BANNER = "=== ESP32 INTERNET RADIO"
+
+
+def parse_soak(line):
+    """Return the SOAK fields of a line as ints, or None."""
+    start = line.find("SOAK ")
+    if start < 0:
+        return None
+    sample = {}
+    for item in line[start + 5:].split():
+        key, sep, value = item.partition("=")
+        if sep and key in FIELDS:
+            try:
+                sample[key] = int(value.rstrip("%"))
+            except ValueError:
+                return None
+    return sample if len(sample) == len(FIELDS) else None
+
+
+def slope_per_hour(points):
+    """Least-squares slope of (seconds, value) points, per hour."""
+    n = len(points)
+    if n < 2:
+        return 0.0
+    mean_x = sum(x for x, _ in points) / n
+    mean_y = sum(y for _, y in points) / n
+    var = sum((x - mean_x) ** 2 for x, _ in points)
+    if var == 0:
+        return 0.0
+    cov = sum((x - mean_x) * (y - mean_y) for x, y in points)
+    return cov / var * 3600
+
+
+class Soak:
+    def __init__(self, csv_path):
+        self.samples = []         # (host seconds, segment, sample)
+        self.segments = 1         # Device runs separated by reboots
+        self.reboots = 0
+        self.stuck = 0
+        self.underruns = 0        # Summed across reboots
+        self.reconnects = 0
+        self.last = None
+        self.start = time.time()
+        self.csv_file = open(csv_path, "w", newline="") if csv_path else None
+        self.csv = None
+        if self.csv_file:
+            self.csv = csv.writer(self.csv_file)
+            self.csv.writerow(["host_s", "segment"] + FIELDS)
+
+    def feed(self, line):
+        if BOOT_BANNER in line and self.samples:
+            self.reboots += 1
+            print(f"*** reboot #{self.reboots} detected", flush=True)
+        if "STUCK" in line:
+            self.stuck += 1
+        sample = parse_soak(line)
+        if sample is None:
+            return
+        if self.last is not None and sample["t"] < self.last["t"]:
+            self.segments += 1  # Device time went backwards: it restarted
+            self.last = None
+        if self.last is not None:
+            self.underruns += sample["underruns"] - self.last["underruns"]
+            self.reconnects += sample["reconnects"] - self.last["reconnects"]
+        else:
+            self.underruns += sample["underruns"]
+            self.reconnects += sample["reconnects"]
+        self.last = sample
+        host_s = time.time() - self.start
+        self.samples.append((host_s, self.segments, sample))
+        if self.csv:
+            self.csv.writerow([f"{host_s:.0f}", self.segments] + [sample[k] for k in FIELDS])
+            self.csv_file.flush()
+
+    def summary(self, leak_bytes_per_hour):
+        print("\n========================================")
+        print("*** SOAK SUMMARY ***")
+        if not self.samples:
+            print(">>> No SOAK lines seen. Is SOAK_TELEMETRY set to 1?")
+            print("========================================")
+            return False
+        # Device time summed over the runs between reboots
+        device_s = 0
+        for segment in range(1, self.segments + 1):
+            ts = [s["t"] for _, seg, s in self.samples if seg == segment]
+            device_s += max(ts) - min(ts)
+        hours = max(device_s / 3600, 1e-9)
+        last_segment = [s for _, seg, s in self.samples if seg == self.segments]
+        heap = [(s["t"], s["heap"]) for s in last_segment]
+        largest = [(s["t"], s["largest"]) for s in last_segment]
+        heap_slope = slope_per_hour(heap)
+        largest_slope = slope_per_hour(largest)
+        final = last_segment[-1]
+
+        print(f">>> Samples: {len(self.samples)} over {device_s / 3600:.2f} h of device time")
+        print(f">>> Reboots: {self.reboots}   STUCK reports: {self.stuck}")
+        print(f">>> Underruns: {self.underruns} ({self.underruns / hours:.1f}/h)   "
+              f"Reconnects: {self.reconnects} ({self.reconnects / hours:.1f}/h)")
+        print(f">>> Heap: now {final['heap']}, low-water {min(s['heap_min'] for s in last_segment)}, "
+              f"drift {final['heap_drift']:+d}, trend {heap_slope:+.0f} B/h")
+        print(f">>> Largest block: now {final['largest']}, drift {final['largest_drift']:+d}, "
+              f"trend {largest_slope:+.0f} B/h, fragmentation {final['frag']}%")
+        leak = len(heap) >= 3 and heap[-1][0] - heap[0][0] >= 3600 and heap_slope < -leak_bytes_per_hour
+        if leak:
+            print(f">>> WARNING: free heap falling faster than {leak_bytes_per_hour} B/h: possible leak")
+        print("========================================")
+        return not leak and self.reboots == 0
+
+
+def serial_lines(port, baud):
+    try:
+        import serial
+    except ImportError:
+        sys.exit("reading a serial port needs pyserial: pip install pyserial")
+    with serial.Serial(port, baud, timeout=1) as link:
+        while True:
+            raw = link.readline()
+            yield raw.decode("utf-8", "replace").rstrip("\r\n") if raw else None
+
+
+def file_lines(path):
+    with (sys.stdin if path == "-" else open(path, errors="replace")) as f:
+        for line in f:
+            yield line.rstrip("\r\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0],
+                                     formatter_class=argparse.RawDescriptionHelpFormatter,
+                                     epilog="\n".join(__doc__.splitlines()[2:]))
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--port", help="serial port of the radio")
+    source.add_argument("--input", help="saved log to summarise ('-' for stdin)")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--hours", type=float, help="stop after this long (serial only)")
+    parser.add_argument("--csv", help="write SOAK samples to this CSV file")
+    parser.add_argument("--log", help="copy every serial line to this file")
+    parser.add_argument("--server", help="command to run alongside, e.g. icy_server.py ...")
+    parser.add_argument("--leak-threshold", type=float, default=2048,
+                        help="free-heap decline in B/h that counts as a leak (default 2048)")
+    parser.add_argument("--quiet", action="store_true", help="only print SOAK lines")
+    args = parser.parse_args()
+
+    server = subprocess.Popen(shlex.split(args.server)) if args.server else None
+    soak = Soak(args.csv)
+    raw_log = open(args.log, "a") if args.log else None
+    deadline = time.time() + args.hours * 3600 if args.hours else None
+    lines = serial_lines(args.port, args.baud) if args.port else file_lines(args.input)
+
+    try:
+        for line in lines:
+            if deadline and time.time() > deadline:
+                break
+            if line is None:
+                continue
+            if raw_log:
+                raw_log.write(f"{time.strftime('%Y-%m-%d %H:%M:%S')} {line}\n")
+                raw_log.flush()
+            if args.port and (not args.quiet or "SOAK" in line):
+                print(line, flush=True)
+            soak.feed(line)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if server:
+            server.terminate()
+            server.wait()
+
+    ok = soak.summary(args.leak_threshold)
+    sys.exit(0 if ok else 1)
+
+
+if __name__ == "__main__":
+    main()